@@ -0,0 +1,51 @@
+#ifndef BUILD_PROFILE_H
+#define BUILD_PROFILE_H
+
+// Build profiles, selected per PlatformIO environment with -D ECU_PROFILE_*.
+// Disabled subsystems are removed at compile time: whole modules and
+// library includes with #if, statement-level code with the constexpr flags
+// below (constant-folded, never tested at runtime).
+//
+//   diagnostic-full     LCD, telemetry, debug log, descriptions, Fahrenheit
+//   headless-telemetry  telemetry only (remote receiver, no LCD)
+//   lcd-only            LCD only (no serial output at all)
+
+#if defined(ECU_PROFILE_HEADLESS_TELEMETRY)
+#define ECU_PROFILE_NAME "headless-telemetry"
+#define ECU_FEATURE_LCD 0
+#define ECU_FEATURE_TELEMETRY 1
+#define ECU_FEATURE_DEBUG_LOG 0
+#define ECU_FEATURE_DESCRIPTIONS 0
+#define ECU_FEATURE_FAHRENHEIT 0
+#elif defined(ECU_PROFILE_LCD_ONLY)
+#define ECU_PROFILE_NAME "lcd-only"
+#define ECU_FEATURE_LCD 1
+#define ECU_FEATURE_TELEMETRY 0
+#define ECU_FEATURE_DEBUG_LOG 0
+#define ECU_FEATURE_DESCRIPTIONS 0
+#define ECU_FEATURE_FAHRENHEIT 0
+#else
+#define ECU_PROFILE_NAME "diagnostic-full"
+#define ECU_FEATURE_LCD 1
+#define ECU_FEATURE_TELEMETRY 1
+#define ECU_FEATURE_DEBUG_LOG 1
+#define ECU_FEATURE_DESCRIPTIONS 1
+#define ECU_FEATURE_FAHRENHEIT 1
+#endif
+
+// Wiring option, independent of the profile: the alternator W terminal on D8
+// (engine speed). Without it the running state is unknown and the oil alarm
+// cannot wait for the engine to start. Override with -D ECU_FEATURE_SPEED_INPUT=0.
+#ifndef ECU_FEATURE_SPEED_INPUT
+#define ECU_FEATURE_SPEED_INPUT 1
+#endif
+
+constexpr bool FEATURE_LCD = ECU_FEATURE_LCD;
+constexpr bool FEATURE_TELEMETRY = ECU_FEATURE_TELEMETRY;
+constexpr bool FEATURE_DEBUG_LOG = ECU_FEATURE_DEBUG_LOG;
+constexpr bool FEATURE_DESCRIPTIONS = ECU_FEATURE_DESCRIPTIONS;
+constexpr bool FEATURE_FAHRENHEIT = ECU_FEATURE_FAHRENHEIT;
+constexpr bool FEATURE_SPEED_INPUT = ECU_FEATURE_SPEED_INPUT;
+constexpr bool FEATURE_SERIAL = FEATURE_TELEMETRY || FEATURE_DEBUG_LOG;
+
+#endif
@@ -0,0 +1,255 @@
+#include "channel_registry.h"
+#include "communication.h"
+#include "temperature_sensor.h"
+#include "fuel_sensor.h"
+#include "engine_speed.h"
+#include "coolant_trend.h"
+#include "watchdog_supervisor.h"
+
+// Battery voltage (switched +12V) through a 30kΩ/10kΩ divider on A2:
+// 20V full scale, published in tenths of a volt
+const uint8_t BATTERY_SENSOR_PIN = A2;
+
+// Telemetry tags
+static const char TAG_OIL[] PROGMEM = "OIL_WARN";
+static const char TAG_COOLANT[] PROGMEM = "COOLANT";
+static const char TAG_FUEL[] PROGMEM = "FUEL";
+static const char TAG_GLOW[] PROGMEM = "GLOW";
+static const char TAG_BATTERY[] PROGMEM = "BATT";
+static const char TAG_RPM[] PROGMEM = "RPM";
+static const char TAG_ENGINE[] PROGMEM = "ENGINE";
+static const char TAG_TEMP_RATE[] PROGMEM = "TEMP_RATE";
+static const char TAG_TEMP_ETA[] PROGMEM = "TEMP_ETA";
+static const char TAG_LOOP_TIME[] PROGMEM = "LOOP_MS";
+
+// Channel descriptor table
+// Coolant: a reading dithering between 86 and 87°C is held by the hysteresis.
+// Fuel: sloshing moves the sender, so changes are rate limited to one per 5s.
+constexpr ChannelDescriptor channelTable[CHANNEL_COUNT] PROGMEM = {
+  // id, source, pin, init, read, readRaw, diagChannel, period, filter, scale, offset,
+  // tag, unit, decimals, display range, alarm low/high,
+  // policy {deadband, hysteresis, min interval, max interval, alarm}
+  { CHANNEL_OIL, SOURCE_EVENT, 0, nullptr, nullptr, nullptr, DIAG_CHANNEL_NONE, 0, 0, 1, 1, 0,
+    TAG_OIL, ' ', 0, 0, 0, ALARM_NONE, ALARM_NONE,
+    { 1, 0, 0, 5000, true } },
+  { CHANNEL_COOLANT, SOURCE_FUNCTION, 0, initializeTemperatureSensor, readTemperatureSensor,
+    getLastTemperatureSensorRaw, DIAG_CHANNEL_COOLANT, 1000, 0, 1, 1, 0,
+    TAG_COOLANT, 'C', 0, 40, 120, ALARM_NONE, 101,
+    { 1, 1, 2000, 30000, false } },
+  { CHANNEL_FUEL, SOURCE_FUNCTION, 0, initializeFuelSensor, readFuelLevel,
+    getLastFuelSensorOversampled, DIAG_CHANNEL_FUEL, 1000, 0, 1, 1, 0,
+    TAG_FUEL, '%', 0, 0, 100, 10, ALARM_NONE,
+    { 2, 2, 5000, 60000, false } },
+  { CHANNEL_GLOW, SOURCE_EVENT, 0, nullptr, nullptr, nullptr, DIAG_CHANNEL_NONE, 0, 0, 1, 1, 0,
+    TAG_GLOW, ' ', 0, 0, 0, ALARM_NONE, ALARM_NONE,
+    { 1, 0, 0, 5000, true } },
+  { CHANNEL_BATTERY, SOURCE_ANALOG, BATTERY_SENSOR_PIN, nullptr, nullptr, nullptr, DIAG_CHANNEL_NONE,
+    1000, 3, 200, 1023, 0,
+    TAG_BATTERY, 'V', 1, 100, 150, 115, 150,
+    { 1, 1, 2000, 30000, false } },
+  // Measured by the Timer1 capture interrupt, reading it is one division
+  { CHANNEL_RPM, SOURCE_FUNCTION, 0, initializeEngineSpeed, readEngineSpeed, nullptr, DIAG_CHANNEL_NONE,
+    250, 0, 1, 1, 0,
+    TAG_RPM, ' ', 0, 0, 5000, ALARM_NONE, ALARM_NONE,
+    { 25, 25, 500, 30000, false } },
+  // Must follow CHANNEL_RPM, whose read updates the running state
+  { CHANNEL_ENGINE, SOURCE_FUNCTION, 0, nullptr, readEngineRunning, nullptr, DIAG_CHANNEL_NONE,
+    250, 0, 1, 1, 0,
+    TAG_ENGINE, ' ', 0, 0, 0, ALARM_NONE, ALARM_NONE,
+    { 1, 0, 0, 5000, true } },
+  // Coolant trend in tenths of °C per minute, period must equal COOLANT_TREND_SAMPLE_MS.
+  // Follows CHANNEL_COOLANT and shares its diagnostics: a sensor fault invalidates the trend.
+  { CHANNEL_TEMP_RATE, SOURCE_FUNCTION, 0, initializeCoolantTrend, readCoolantTemperatureRate, nullptr,
+    DIAG_CHANNEL_COOLANT, 2500, 0, 1, 1, 0,
+    TAG_TEMP_RATE, ' ', 1, 0, 100, ALARM_NONE, ALARM_NONE,
+    { 2, 2, 5000, 60000, false } },
+  // Projected seconds until coolant is critical, must follow CHANNEL_TEMP_RATE.
+  // Predictive overheat warning at 2 minutes or less.
+  { CHANNEL_TEMP_ETA, SOURCE_FUNCTION, 0, nullptr, readCoolantTimeToCritical, nullptr,
+    DIAG_CHANNEL_COOLANT, 2500, 0, 1, 1, 0,
+    TAG_TEMP_ETA, 's', 0, 0, 0, 120, ALARM_NONE,
+    { 10, 0, 5000, 60000, false } },
+  // Peak loop time over each 5s window, in tenths of a millisecond.
+  // Diagnostic only: no display range, so no dashboard page for the driver.
+  { CHANNEL_LOOP_TIME, SOURCE_FUNCTION, 0, nullptr, readLoopTimePeak, nullptr, DIAG_CHANNEL_NONE,
+    5000, 0, 1, 1, 0,
+    TAG_LOOP_TIME, 'm', 1, 0, 0, ALARM_NONE, ALARM_NONE,
+    { 5, 5, 5000, 60000, false } }
+};
+
+constexpr bool isTableOrdered(uint8_t index = 0) {
+  return index == CHANNEL_COUNT || (channelTable[index].id == index && isTableOrdered(index + 1));
+}
+static_assert(isTableOrdered(), "channelTable entries must be in ChannelId order");
+
+// Runtime state, kept small and contiguous. Per loop, the pass reads each
+// channel's 4-byte heartbeat interval from flash. It copies the whole
+// descriptor only when a channel is due, and the policy only when a changed
+// value or a heartbeat is pending.
+struct ChannelRuntime {
+  int value;
+  long filterAccumulator;     // Raw value << filterShift
+  unsigned long nextSample;
+  uint16_t samplePeriodMs;    // Copied from the descriptor, 0 = event channel
+  bool valid;
+  bool alarm;
+  bool filterPrimed;
+};
+
+static ChannelRuntime channelRuntime[CHANNEL_COUNT];
+
+void getChannelDescriptor(ChannelId id, ChannelDescriptor& descriptor) {
+  memcpy_P(&descriptor, &channelTable[id], sizeof(ChannelDescriptor));
+}
+
+void getChannelPolicy(ChannelId id, PublishPolicy& policy) {
+  memcpy_P(&policy, &channelTable[id].policy, sizeof(PublishPolicy));
+}
+
+// Heartbeat interval alone, read on every pass without copying the whole policy
+unsigned long getChannelHeartbeatMs(ChannelId id) {
+  return pgm_read_dword(&channelTable[id].policy.maxIntervalMs);
+}
+
+// Channels that convert on the ADC: analog pins, and sensors whose raw sample
+// feeds diagnostics. Derived channels (readRaw == nullptr) only read values.
+static bool usesAdc(ChannelId id) {
+  return pgm_read_byte(&channelTable[id].source) == SOURCE_ANALOG ||
+         pgm_read_ptr(&channelTable[id].readRaw) != nullptr;
+}
+
+PGM_P getChannelTag(ChannelId id) {
+  return (PGM_P)pgm_read_ptr(&channelTable[id].tag);
+}
+
+// Read, filter and scale one sample of an analog channel
+static int acquireAnalog(const ChannelDescriptor& descriptor, ChannelRuntime& runtime) {
+  long raw = analogRead(descriptor.pin);
+
+  if (!runtime.filterPrimed) {
+    runtime.filterAccumulator = raw << descriptor.filterShift;
+    runtime.filterPrimed = true;
+  } else {
+    runtime.filterAccumulator += raw - (runtime.filterAccumulator >> descriptor.filterShift);
+  }
+
+  long filtered = runtime.filterAccumulator >> descriptor.filterShift;
+  return filtered * descriptor.scaleNum / descriptor.scaleDen + descriptor.offset;
+}
+
+// Re-evaluate the alarm thresholds, returns true if the alarm state changed
+static bool updateAlarm(const ChannelDescriptor& descriptor, ChannelRuntime& runtime) {
+  bool alarm = (descriptor.alarmLow != ALARM_NONE && runtime.value <= descriptor.alarmLow) ||
+               (descriptor.alarmHigh != ALARM_NONE && runtime.value >= descriptor.alarmHigh);
+
+  if (alarm == runtime.alarm) {
+    return false;
+  }
+  runtime.alarm = alarm;
+  sendChannelAlarm((ChannelId)descriptor.id, alarm);
+  return true;
+}
+
+static void sampleChannel(ChannelId id) {
+  ChannelDescriptor descriptor;
+  getChannelDescriptor(id, descriptor);
+  ChannelRuntime& runtime = channelRuntime[id];
+
+  int value = descriptor.source == SOURCE_ANALOG ? acquireAnalog(descriptor, runtime) : descriptor.read();
+
+  // Diagnostics run on the sample just taken, no extra conversion
+  if (descriptor.diagChannel != DIAG_CHANNEL_NONE) {
+    if (descriptor.readRaw != nullptr) {
+      processSensorSample((DiagnosticChannel)descriptor.diagChannel, descriptor.readRaw());
+    }
+    runtime.valid = isSensorValueValid((DiagnosticChannel)descriptor.diagChannel);
+  }
+
+  // Values that failed diagnostics are not passed on
+  if (runtime.valid) {
+    runtime.value = value;
+    bool alarmChanged = updateAlarm(descriptor, runtime);
+    publishChannelValue(id, value, alarmChanged, micros());
+  } else if (runtime.alarm) {
+    // The last good value no longer stands, its fault is reported as a DTC
+    runtime.alarm = false;
+    sendChannelAlarm(id, false);
+  }
+}
+
+/**
+ * Initialise every channel's module and take the first samples
+ */
+void initializeChannels() {
+  initializeSensorDiagnostics();
+
+  unsigned long now = millis();
+  for (uint8_t id = 0; id < CHANNEL_COUNT; id++) {
+    ChannelDescriptor descriptor;
+    getChannelDescriptor((ChannelId)id, descriptor);
+    ChannelRuntime& runtime = channelRuntime[id];
+
+    // Event channels may already hold a value pushed during setup
+    runtime.valid = true;
+    runtime.samplePeriodMs = descriptor.samplePeriodMs;
+    runtime.nextSample = now;
+
+    if (descriptor.source == SOURCE_ANALOG) {
+      pinMode(descriptor.pin, INPUT);
+    }
+    if (descriptor.init != nullptr) {
+      descriptor.init();
+    }
+  }
+
+  updateChannels();
+}
+
+/**
+ * Sample due channels and service their telemetry in one pass
+ * Call once per loop.
+ */
+void updateChannels() {
+  for (uint8_t id = 0; id < CHANNEL_COUNT; id++) {
+    ChannelRuntime& runtime = channelRuntime[id];
+
+    // ADC channels due while the fuel sender holds the 1.1V reference wait
+    // for the pass that releases it, a few milliseconds later
+    if (runtime.samplePeriodMs != 0 && (long)(millis() - runtime.nextSample) >= 0 &&
+        !(isFuelSensorHoldingReference() && usesAdc((ChannelId)id))) {
+      runtime.nextSample = millis() + runtime.samplePeriodMs;
+      sampleChannel((ChannelId)id);
+    }
+
+    serviceChannelTelemetry((ChannelId)id, millis());
+  }
+}
+
+/**
+ * Push a new value for an event channel (oil switch, glow plug)
+ * @param eventMicros When the event happened, for alarm latency (micros())
+ */
+void setChannelValue(ChannelId id, int value, unsigned long eventMicros) {
+  ChannelRuntime& runtime = channelRuntime[id];
+  runtime.value = value;
+  publishChannelValue(id, value, false, eventMicros);
+}
+
+/**
+ * Push a new value for an event channel, observed now
+ */
+void setChannelValue(ChannelId id, int value) {
+  setChannelValue(id, value, micros());
+}
+
+int getChannelValue(ChannelId id) {
+  return channelRuntime[id].value;
+}
+
+bool isChannelValid(ChannelId id) {
+  return channelRuntime[id].valid;
+}
+
+bool isChannelInAlarm(ChannelId id) {
+  return channelRuntime[id].alarm;
+}
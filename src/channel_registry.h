@@ -0,0 +1,85 @@
+#ifndef CHANNEL_REGISTRY_H
+#define CHANNEL_REGISTRY_H
+
+#include <Arduino.h>
+#include "sensor_diagnostics.h"
+
+// Every value the ECU publishes. The order must match the descriptor table.
+enum ChannelId {
+  CHANNEL_OIL,
+  CHANNEL_COOLANT,
+  CHANNEL_FUEL,
+  CHANNEL_GLOW,
+  CHANNEL_BATTERY,
+  CHANNEL_RPM,
+  CHANNEL_ENGINE,
+  CHANNEL_TEMP_RATE,
+  CHANNEL_TEMP_ETA,
+  CHANNEL_LOOP_TIME,
+  CHANNEL_COUNT
+};
+
+// Where a channel's value comes from
+enum ChannelSource {
+  SOURCE_EVENT,     // Pushed by its module with setChannelValue()
+  SOURCE_FUNCTION,  // Sampled by calling the descriptor's read function
+  SOURCE_ANALOG     // Sampled straight from the descriptor's analog pin
+};
+
+// When a changed value is worth sending
+struct PublishPolicy {
+  int deadband;                // Minimum change from the last sent value
+  int hysteresis;              // Extra change required when the direction reverses
+  unsigned long minIntervalMs; // Rate limit between sends (0 = none)
+  unsigned long maxIntervalMs; // Heartbeat: resend an unchanged value (0 = never)
+  bool alarm;                  // Send every change immediately, bypassing the limits above
+};
+
+// Marks a disabled alarm threshold or diagnostics link
+const int ALARM_NONE = -32767 - 1;
+const uint8_t DIAG_CHANNEL_NONE = 0xFF;
+
+// Static description of one channel, stored in flash
+struct ChannelDescriptor {
+  uint8_t id;                 // ChannelId, must equal the table index
+  uint8_t source;             // ChannelSource
+  uint8_t pin;                // SOURCE_ANALOG input pin
+  void (*init)();             // Module initialisation (nullptr = none)
+  int (*read)();              // SOURCE_FUNCTION: engineering value
+  int (*readRaw)();           // Raw sample of the last read, for diagnostics
+                              // (nullptr = derived channel, only inherits validity)
+  uint8_t diagChannel;        // DiagnosticChannel or DIAG_CHANNEL_NONE
+  uint16_t samplePeriodMs;    // 0 for event channels
+  uint8_t filterShift;        // EMA: y += (x - y) / 2^shift (0 = unfiltered)
+  int16_t scaleNum;           // value = raw * scaleNum / scaleDen + offset
+  int16_t scaleDen;
+  int16_t offset;
+  PGM_P tag;                  // Telemetry key, also the display label
+  char unit;                  // Display unit
+  uint8_t decimals;           // Fixed decimals in the value (1 = tenths)
+  int16_t displayMin;         // Bar graph range (equal values = no bar page)
+  int16_t displayMax;
+  int16_t alarmLow;           // Alarm at or below (ALARM_NONE = disabled)
+  int16_t alarmHigh;          // Alarm at or above (ALARM_NONE = disabled)
+  PublishPolicy policy;
+};
+
+// Current values published through telemetry
+struct SensorState {
+  int values[CHANNEL_COUNT];
+};
+
+// Channel registry functions
+void initializeChannels();
+void updateChannels();
+void setChannelValue(ChannelId id, int value);
+void setChannelValue(ChannelId id, int value, unsigned long eventMicros);
+int getChannelValue(ChannelId id);
+bool isChannelValid(ChannelId id);
+bool isChannelInAlarm(ChannelId id);
+void getChannelDescriptor(ChannelId id, ChannelDescriptor& descriptor);
+void getChannelPolicy(ChannelId id, PublishPolicy& policy);
+unsigned long getChannelHeartbeatMs(ChannelId id);
+PGM_P getChannelTag(ChannelId id);
+
+#endif
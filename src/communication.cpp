@@ -1,72 +1,458 @@
 #include "communication.h"
+#include "build_profile.h"
 
-// State tracking variables
-static SensorState currentState = {0, 0, 0, false}; // Initialize with zero values
-static SensorState lastSentState = {0, 0, 0, false}; // Initialize with zero values
+const unsigned long TELEMETRY_BAUD_RATE = 115200;
+const unsigned long PUBLISH_STATS_INTERVAL_MS = 60000; // Report counters every minute
 
-// Functions to send individual sensor data when changed or forced
-static void sendOilData(bool force = false) {
-  if (force || currentState.oil != lastSentState.oil) {
-    Serial.print("OIL_WARN:");
-    Serial.println(currentState.oil);
-    lastSentState.oil = currentState.oil;
+// Outbound priorities: alarm-class messages (alarm-policy channels, ALARM_SET/CLR,
+// DTC_SET/CLR) are written as soon as they are queued and carry a sequence number
+// ("OIL_WARN:1#17"). They are repeated with backoff until the receiver answers
+// "ACK:17". Routine telemetry waits in a per-channel slot (newest value wins) and
+// is only written while the TX buffer holds less than ROUTINE_TX_LIMIT bytes, so
+// an alarm never queues behind more than that.
+const uint8_t ALARM_QUEUE_LENGTH = 8;
+const unsigned long ALARM_RETRY_INITIAL_MS = 250;
+const unsigned long ALARM_RETRY_MAX_MS = 8000;
+const uint8_t ROUTINE_TX_LIMIT = 16;
+// Event to first byte on the wire. For the oil switch the event is the raw
+// edge, so this is the 100ms switch debounce plus 5ms for the main loop and
+// the TX backlog.
+const unsigned long ALARM_LATENCY_BUDGET_US = 105000;
+
+const uint8_t MESSAGE_LINE_LENGTH = 28; // "ALARM_CLR:OIL_WARN#255\n" plus margin
+const uint8_t RX_LINE_LENGTH = 12;      // "ACK:255"
+const unsigned long SERIAL_BYTE_TIME_US = 10000000UL / TELEMETRY_BAUD_RATE; // 8N1
+
+// Per-channel publishing state (policies live in the channel descriptor table)
+struct PublishState {
+  int current;
+  int lastSent;
+  int8_t lastDirection;        // Direction of the last published change (-1, 0, 1)
+  unsigned long lastSentMillis;
+  unsigned long eventMicros;   // When the current value was observed
+  unsigned long sentCount;
+  unsigned long suppressedCount;
+};
+
+enum AlarmMessageKind : uint8_t {
+  ALARM_MESSAGE_VALUE,   // TAG:value from an alarm-policy channel
+  ALARM_MESSAGE_LIMIT,   // ALARM_SET/CLR:TAG
+  ALARM_MESSAGE_DTC      // DTC_SET/CLR:Pxxxx
+};
+
+struct AlarmMessage {
+  uint8_t sequence;      // 0 = free slot
+  uint8_t kind;
+  uint16_t subject;      // Channel or trouble code
+  int value;             // Channel value, or 1/0 for set/clear
+  uint8_t attempts;
+  unsigned long eventMicros;   // When the event that raised it was observed
+  unsigned long lastSendMillis;
+};
+
+static PublishState publishStates[CHANNEL_COUNT]; // Zero initialised
+static unsigned long lastStatsReport = 0;
+
+// Routine telemetry waiting for room in the TX buffer, one bit per channel
+static_assert(CHANNEL_COUNT <= 16, "routine pending mask is 16 bits");
+static uint16_t routinePending = 0;
+static uint8_t routineCursor = 0;
+
+static AlarmMessage alarmQueue[ALARM_QUEUE_LENGTH];
+static uint8_t lastSequence = 0;
+static unsigned long alarmsAcked = 0;
+static unsigned long alarmRetries = 0;
+static unsigned long alarmsDropped = 0;
+static unsigned long alarmLatencyPeakUs = 0;
+static unsigned long alarmLatencyOverruns = 0;
+
+static char rxLine[RX_LINE_LENGTH];
+static uint8_t rxLength = 0;
+static bool rxOverflow = false;
+
+static void printTag(ChannelId channel) {
+  Serial.print((const __FlashStringHelper*)getChannelTag(channel));
+}
+
+// Bytes already waiting in the TX buffer ahead of anything written now
+static uint8_t getTxBacklog() {
+  return SERIAL_TX_BUFFER_SIZE - 1 - Serial.availableForWrite();
+}
+
+static uint8_t formatValueLine(char* line, ChannelId channel, int value) {
+  strcpy_P(line, getChannelTag(channel));
+  uint8_t length = strlen(line);
+  line[length++] = ':';
+  itoa(value, line + length, 10);
+  return strlen(line);
+}
+
+static uint8_t formatAlarmLine(char* line, const AlarmMessage& message) {
+  uint8_t length;
+  if (message.kind == ALARM_MESSAGE_VALUE) {
+    length = formatValueLine(line, (ChannelId)message.subject, message.value);
+  } else {
+    bool limit = message.kind == ALARM_MESSAGE_LIMIT;
+    strcpy_P(line, message.value
+        ? (limit ? PSTR("ALARM_SET:") : PSTR("DTC_SET:"))
+        : (limit ? PSTR("ALARM_CLR:") : PSTR("DTC_CLR:")));
+    length = strlen(line);
+    if (limit) {
+      strcpy_P(line + length, getChannelTag((ChannelId)message.subject));
+    } else {
+      formatTroubleCode(message.subject, line + length);
+    }
+    length = strlen(line);
+  }
+
+  line[length++] = '#';
+  itoa(message.sequence, line + length, 10);
+  length = strlen(line);
+  line[length++] = '\n';
+  return length;
+}
+
+static unsigned long getAlarmRetryDelay(uint8_t attempts) {
+  // 250, 500, 1000 ... capped at ALARM_RETRY_MAX_MS
+  return attempts >= 6 ? ALARM_RETRY_MAX_MS : min(ALARM_RETRY_INITIAL_MS << (attempts - 1), ALARM_RETRY_MAX_MS);
+}
+
+static void transmitAlarm(AlarmMessage& message, unsigned long now) {
+  char line[MESSAGE_LINE_LENGTH];
+  uint8_t length = formatAlarmLine(line, message);
+
+  if (message.attempts == 0) {
+    // From the event (the raw oil switch edge, or the sample that crossed a limit)
+    // until the first byte reaches the wire: debounce, loop delay and TX backlog
+    unsigned long latencyUs = micros() - message.eventMicros + getTxBacklog() * SERIAL_BYTE_TIME_US;
+    if (latencyUs > alarmLatencyPeakUs) {
+      alarmLatencyPeakUs = latencyUs;
+    }
+    if (latencyUs > ALARM_LATENCY_BUDGET_US) {
+      alarmLatencyOverruns++;
+    }
+    if (message.kind == ALARM_MESSAGE_VALUE) {
+      publishStates[message.subject].sentCount++;
+    }
+  } else {
+    alarmRetries++;
+  }
+
+  // Alarms may block on a full TX buffer: routine telemetry keeps it short
+  Serial.write(line, length);
+  if (message.attempts < 255) {
+    message.attempts++;
+  }
+  message.lastSendMillis = now;
+}
+
+static void transmitDueAlarms(unsigned long now) {
+  for (uint8_t i = 0; i < ALARM_QUEUE_LENGTH; i++) {
+    AlarmMessage& message = alarmQueue[i];
+    if (message.sequence == 0) {
+      continue;
+    }
+    if (message.attempts == 0 || now - message.lastSendMillis >= getAlarmRetryDelay(message.attempts)) {
+      transmitAlarm(message, now);
+    }
+  }
+}
+
+/**
+ * Queue an alarm-class message and write it straight away
+ * A newer message about the same subject replaces an unacknowledged one.
+ * @param eventMicros When the event was observed, latency is measured from it
+ */
+static void queueAlarm(AlarmMessageKind kind, uint16_t subject, int value, unsigned long eventMicros) {
+  AlarmMessage* slot = nullptr;
+  AlarmMessage* mostRetried = &alarmQueue[0];
+  for (uint8_t i = 0; i < ALARM_QUEUE_LENGTH; i++) {
+    AlarmMessage& message = alarmQueue[i];
+    if (message.sequence != 0 && message.kind == kind && message.subject == subject) {
+      slot = &message;
+      break;
+    }
+    if (slot == nullptr && message.sequence == 0) {
+      slot = &message;
+    }
+    if (message.attempts > mostRetried->attempts) {
+      mostRetried = &message;
+    }
+  }
+  if (slot == nullptr) {
+    // Queue full: give up on the message the receiver has ignored longest
+    slot = mostRetried;
+    alarmsDropped++;
+  }
+
+  lastSequence = lastSequence == 255 ? 1 : lastSequence + 1;
+  slot->sequence = lastSequence;
+  slot->kind = kind;
+  slot->subject = subject;
+  slot->value = value;
+  slot->attempts = 0;
+  slot->eventMicros = eventMicros;
+
+  transmitDueAlarms(millis());
+}
+
+static void handleReceivedLine(const char* line) {
+  if (strncmp(line, "ACK:", 4) != 0) {
+    return;
+  }
+
+  int sequence = atoi(line + 4);
+  for (uint8_t i = 0; i < ALARM_QUEUE_LENGTH; i++) {
+    // An ACK for a superseded sequence number leaves the newer message queued
+    if (sequence > 0 && alarmQueue[i].sequence == sequence) {
+      alarmQueue[i].sequence = 0;
+      alarmsAcked++;
+      return;
+    }
+  }
+}
+
+static void pollAcknowledgements() {
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c == '\n' || c == '\r') {
+      rxLine[rxLength] = '\0';
+      if (!rxOverflow && rxLength > 0) {
+        handleReceivedLine(rxLine);
+      }
+      rxLength = 0;
+      rxOverflow = false;
+    } else if (rxLength < RX_LINE_LENGTH - 1) {
+      rxLine[rxLength++] = c;
+    } else {
+      rxOverflow = true;
+    }
+  }
+}
+
+// Write pending routine values while the TX buffer has room, round robin
+static void drainRoutineTelemetry() {
+  for (uint8_t checked = 0; checked < CHANNEL_COUNT && routinePending != 0; checked++) {
+    uint8_t channel = routineCursor;
+    routineCursor = (routineCursor + 1) % CHANNEL_COUNT;
+    if (!(routinePending & (1U << channel))) {
+      continue;
+    }
+
+    char line[MESSAGE_LINE_LENGTH];
+    uint8_t length = formatValueLine(line, (ChannelId)channel, publishStates[channel].lastSent);
+    line[length++] = '\n';
+    uint8_t backlog = getTxBacklog();
+    if (backlog > 0 && backlog + length > ROUTINE_TX_LIMIT) {
+      routineCursor = channel; // Resume here next time
+      return;
+    }
+
+    Serial.write(line, length);
+    routinePending &= ~(1U << channel);
+    publishStates[channel].sentCount++;
   }
 }
 
-static void sendCoolantData(bool force = false) {
-  if (force || currentState.coolant != lastSentState.coolant) {
-    Serial.print("COOLANT:");
-    Serial.println(currentState.coolant);
-    lastSentState.coolant = currentState.coolant;
+static void publish(ChannelId channel, const PublishPolicy& policy) {
+  PublishState& state = publishStates[channel];
+  int delta = state.current - state.lastSent;
+  if (delta != 0) {
+    state.lastDirection = delta > 0 ? 1 : -1;
+  }
+  state.lastSent = state.current;
+  state.lastSentMillis = millis();
+
+  if (!FEATURE_TELEMETRY) {
+    state.sentCount++;
+    return;
+  }
+
+  // Only a real change of an alarm channel is sequenced and retried;
+  // a heartbeat repeats a value already delivered and goes out as routine
+  if (policy.alarm && delta != 0) {
+    queueAlarm(ALARM_MESSAGE_VALUE, channel, state.current, state.eventMicros);
+  } else {
+    if (routinePending & (1U << channel)) {
+      state.suppressedCount++; // Replaced before it was written
+    }
+    routinePending |= 1U << channel;
   }
 }
 
-static void sendFuelData(bool force = false) {
-  if (force || currentState.fuel != lastSentState.fuel) {
-    Serial.print("FUEL:");
-    Serial.println(currentState.fuel);
-    lastSentState.fuel = currentState.fuel;
+// Decide whether the current value of a channel passes its policy
+static bool shouldPublish(ChannelId channel, const PublishPolicy& policy, unsigned long now) {
+  const PublishState& state = publishStates[channel];
+  int delta = state.current - state.lastSent;
+
+  if (delta == 0) {
+    return false;
+  }
+  if (policy.alarm) {
+    return true;
+  }
+
+  int direction = delta > 0 ? 1 : -1;
+  int threshold = policy.deadband;
+  if (state.lastDirection != 0 && direction != state.lastDirection) {
+    threshold += policy.hysteresis;
   }
+  if (abs(delta) < threshold) {
+    return false;
+  }
+
+  return now - state.lastSentMillis >= policy.minIntervalMs;
 }
 
-static void sendGlowData(bool force = false) {
-  if (force || currentState.glowActive != lastSentState.glowActive) {
-    Serial.print("GLOW:");
-    Serial.println(currentState.glowActive ? 1 : 0);
-    lastSentState.glowActive = currentState.glowActive;
+/**
+ * Offer a new value for a channel, sent if its policy allows
+ * @param bypassPolicy Send any change immediately (alarm state changed)
+ * @param eventMicros When the value was observed (micros())
+ */
+void publishChannelValue(ChannelId channel, int value, bool bypassPolicy, unsigned long eventMicros) {
+  PublishState& state = publishStates[channel];
+  state.current = value;
+  state.eventMicros = eventMicros;
+
+  PublishPolicy policy;
+  getChannelPolicy(channel, policy);
+
+  if ((bypassPolicy && value != state.lastSent) || shouldPublish(channel, policy, millis())) {
+    publish(channel, policy);
+  } else if (value != state.lastSent) {
+    state.suppressedCount++;
   }
 }
 
+/**
+ * Send a value held back by a rate limit, or a heartbeat when one is due
+ * Nothing is sent while diagnostics mark the channel invalid: the last good
+ * value must not keep going out for a sensor that has failed.
+ */
+void serviceChannelTelemetry(ChannelId channel, unsigned long now) {
+  if (!isChannelValid(channel)) {
+    return;
+  }
+
+  const PublishState& state = publishStates[channel];
+  unsigned long heartbeatMs = getChannelHeartbeatMs(channel);
+  bool heartbeatDue = heartbeatMs > 0 && now - state.lastSentMillis >= heartbeatMs;
+
+  // Common case: nothing held back and no heartbeat due, the policy stays in flash
+  if (!heartbeatDue && state.current == state.lastSent) {
+    return;
+  }
+
+  PublishPolicy policy;
+  getChannelPolicy(channel, policy);
+
+  if (heartbeatDue || shouldPublish(channel, policy, now)) {
+    publish(channel, policy);
+  }
+}
+
+static void reportPublishCounters() {
+  Serial.print("Telemetry sent/suppressed:");
+  for (uint8_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+    Serial.print(' ');
+    printTag((ChannelId)channel);
+    Serial.print('=');
+    Serial.print(publishStates[channel].sentCount);
+    Serial.print('/');
+    Serial.print(publishStates[channel].suppressedCount);
+  }
+  Serial.println();
+
+  uint8_t pending = 0;
+  for (uint8_t i = 0; i < ALARM_QUEUE_LENGTH; i++) {
+    pending += alarmQueue[i].sequence != 0;
+  }
+  Serial.print("Alarms pending/acked/retried/dropped: ");
+  Serial.print(pending);
+  Serial.print('/');
+  Serial.print(alarmsAcked);
+  Serial.print('/');
+  Serial.print(alarmRetries);
+  Serial.print('/');
+  Serial.print(alarmsDropped);
+  Serial.print(", event to first byte peak ");
+  Serial.print(alarmLatencyPeakUs);
+  Serial.print("us, ");
+  Serial.print(alarmLatencyOverruns);
+  Serial.println(" over budget");
+}
+
 void initializeCommunication() {
   // Send initial sensor data to display microcontroller
-  Serial.println("Sending initial sensor data...");
+  if (FEATURE_DEBUG_LOG) {
+    Serial.println("Sending initial sensor data...");
+  }
   sendAllSensorData(true);
 }
 
 void sendAllSensorData(bool force) {
-  sendOilData(force);
-  sendCoolantData(force);
-  sendFuelData(force);
-  sendGlowData(force);
+  unsigned long now = millis();
+  for (uint8_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+    PublishPolicy policy;
+    getChannelPolicy((ChannelId)channel, policy);
+    if (force || shouldPublish((ChannelId)channel, policy, now)) {
+      publish((ChannelId)channel, policy);
+    }
+  }
 }
 
-// Individual sensor update functions
-void updateOilState(int oilValue) {
-  currentState.oil = oilValue;
-  sendOilData(); // Send immediately when changed
+/**
+ * Read acknowledgements, repeat unacknowledged alarms, then write routine
+ * telemetry while the TX buffer has room. Counter report (debug log only).
+ * Call once per loop.
+ */
+void serviceTelemetry() {
+  unsigned long now = millis();
+  if (FEATURE_TELEMETRY) {
+    pollAcknowledgements();
+    transmitDueAlarms(now);
+    drainRoutineTelemetry();
+  }
+
+  if (FEATURE_DEBUG_LOG && now - lastStatsReport >= PUBLISH_STATS_INTERVAL_MS) {
+    lastStatsReport = now;
+    reportPublishCounters();
+  }
+}
+
+/**
+ * Get the values as last sent, so local displays follow the same policies
+ */
+SensorState getPublishedSensorState() {
+  SensorState state;
+  for (uint8_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+    state.values[channel] = publishStates[channel].lastSent;
+  }
+  return state;
+}
+
+unsigned long getSentMessageCount(ChannelId channel) {
+  return publishStates[channel].sentCount;
 }
 
-void updateCoolantState(int coolantValue) {
-  currentState.coolant = coolantValue;
-  sendCoolantData(); // Send immediately when changed
+unsigned long getSuppressedMessageCount(ChannelId channel) {
+  return publishStates[channel].suppressedCount;
 }
 
-void updateFuelState(int fuelValue) {
-  currentState.fuel = fuelValue;
-  sendFuelData(); // Send immediately when changed
+// Alarm thresholds from the descriptor table, sent (acknowledged) on every transition
+void sendChannelAlarm(ChannelId channel, bool active) {
+  if (!FEATURE_TELEMETRY) {
+    return;
+  }
+
+  queueAlarm(ALARM_MESSAGE_LIMIT, channel, active ? 1 : 0, micros());
 }
 
-void updateGlowState(bool glowActive) {
-  currentState.glowActive = glowActive;
-  sendGlowData(); // Send immediately when changed
+// Trouble codes are sent (acknowledged) on every set/clear transition
+void sendTroubleCode(uint16_t code, bool active) {
+  if (!FEATURE_TELEMETRY) {
+    return;
+  }
+
+  queueAlarm(ALARM_MESSAGE_DTC, code, active ? 1 : 0, micros());
 }
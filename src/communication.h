@@ -2,23 +2,30 @@
 #define COMMUNICATION_H
 
 #include <Arduino.h>
+#include "channel_registry.h"
 
-// State tracking for sensor data transmission
-struct SensorState {
-  int oil;
-  int coolant;
-  int fuel;
-  bool glowActive;
-};
+extern const unsigned long TELEMETRY_BAUD_RATE;
+extern const unsigned long PUBLISH_STATS_INTERVAL_MS;
+extern const uint8_t ALARM_QUEUE_LENGTH;
+extern const unsigned long ALARM_RETRY_INITIAL_MS;
+extern const unsigned long ALARM_RETRY_MAX_MS;
+extern const uint8_t ROUTINE_TX_LIMIT;
+extern const unsigned long ALARM_LATENCY_BUDGET_US;
 
 // Communication functions
 void initializeCommunication();
 void sendAllSensorData(bool force = false);
+void serviceTelemetry();
+SensorState getPublishedSensorState();
+unsigned long getSentMessageCount(ChannelId channel);
+unsigned long getSuppressedMessageCount(ChannelId channel);
 
-// Individual sensor update functions
-void updateOilState(int oilValue);
-void updateCoolantState(int coolantValue);
-void updateFuelState(int fuelValue);
-void updateGlowState(bool glowActive);
+// Channel publishing (called by the channel registry)
+void publishChannelValue(ChannelId channel, int value, bool bypassPolicy, unsigned long eventMicros);
+void serviceChannelTelemetry(ChannelId channel, unsigned long now);
+
+// Alarm and diagnostic trouble code reporting
+void sendChannelAlarm(ChannelId channel, bool active);
+void sendTroubleCode(uint16_t code, bool active);
 
 #endif
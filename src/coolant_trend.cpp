@@ -0,0 +1,140 @@
+#include "coolant_trend.h"
+#include "channel_registry.h"
+
+// Least-squares slope of the coolant temperature over a sliding window,
+// updated in O(1) per sample from integer running sums. Samples are indexed
+// x = 0 (oldest) .. N-1 (newest). When the window slides every x drops by
+// one and the oldest sample y0 (at x = 0) leaves, so:
+//   Sxy' = Sxy - (Sy - y0) + (N-1) * yN
+//   Sy'  = Sy - y0 + yN
+//
+// A longer window smooths the 1°C steps of the sensor but lags a sudden rise.
+// With 1 minute, a water pump failure climbing 5°C/min from 88°C is flagged
+// ~100s before the coolant alarm.
+//
+// A straight line knows nothing of the thermostat: a fast warm-up heading for
+// 88°C would project an overheat (8°C/min bottoms out at ~100s). Nothing is
+// projected until the coolant reads above the thermostat plateau, so only a
+// rise past the point where the thermostat should hold it can warn. Both are
+// checked on the host by tools/coolant_trend_test.
+const uint8_t COOLANT_TREND_WINDOW = 24;            // 1 minute of samples
+const unsigned long COOLANT_TREND_SAMPLE_MS = 2500; // TEMP_RATE sample period in the channel table
+const uint8_t COOLANT_TREND_MIN_SAMPLES = 12;       // 30s of history before a slope is reported
+const int COOLANT_TREND_CRITICAL_TEMP = 101;        // First reading isTemperatureCritical() flags
+const int COOLANT_TREND_PROJECT_MIN_TEMP = 90;      // Above the 88°C thermostat plateau and its dither
+const int COOLANT_TREND_MIN_RATE_X10 = 5;           // Slower rises (< 0.5°C/min) never project an overheat
+const int COOLANT_TREND_ETA_MAX_S = 3600;           // An hour or more, also reported when not rising
+
+// Samples per minute times 10: converts a slope per sample into tenths of °C per minute
+const long COOLANT_TREND_RATE_SCALE = 600000L / COOLANT_TREND_SAMPLE_MS;
+
+// Window and running sums (24 x 2 + 12 bytes)
+static int16_t samples[COOLANT_TREND_WINDOW];
+static uint8_t oldestIndex = 0;
+static uint8_t sampleCount = 0;
+static long sumY = 0;
+static long sumXY = 0;
+
+// Latest estimate
+static int rateX10 = 0;
+static int etaSeconds = COOLANT_TREND_ETA_MAX_S;
+
+static void resetTrend() {
+  oldestIndex = 0;
+  sampleCount = 0;
+  sumY = 0;
+  sumXY = 0;
+}
+
+static void addSample(int temperature) {
+  if (sampleCount < COOLANT_TREND_WINDOW) {
+    // Filling: the new sample lands at x = sampleCount
+    samples[(oldestIndex + sampleCount) % COOLANT_TREND_WINDOW] = temperature;
+    sumXY += (long)sampleCount * temperature;
+    sumY += temperature;
+    sampleCount++;
+    return;
+  }
+
+  int oldest = samples[oldestIndex];
+  sumXY += (long)(COOLANT_TREND_WINDOW - 1) * temperature - (sumY - oldest);
+  sumY += temperature - oldest;
+  samples[oldestIndex] = temperature;
+  oldestIndex = (oldestIndex + 1) % COOLANT_TREND_WINDOW;
+}
+
+// Integer division rounded to nearest (denominator > 0)
+static long divideRounded(long numerator, long denominator) {
+  return (numerator >= 0 ? numerator + denominator / 2 : numerator - denominator / 2) / denominator;
+}
+
+static void updateEstimate(int latest) {
+  if (sampleCount < COOLANT_TREND_MIN_SAMPLES) {
+    rateX10 = 0;
+    etaSeconds = COOLANT_TREND_ETA_MAX_S;
+    return;
+  }
+
+  // slope = (n*Sxy - Sx*Sy) / (n*Sxx - Sx^2), with Sx and Sxx fixed for n samples
+  long n = sampleCount;
+  long sumX = n * (n - 1) / 2;
+  long denominator = n * n * (n * n - 1) / 12;
+  long numerator = n * sumXY - sumX * sumY;
+  rateX10 = divideRounded(numerator * COOLANT_TREND_RATE_SCALE, denominator);
+
+  if (latest >= COOLANT_TREND_CRITICAL_TEMP) {
+    etaSeconds = 0;
+    return;
+  }
+  if (rateX10 < COOLANT_TREND_MIN_RATE_X10 || latest < COOLANT_TREND_PROJECT_MIN_TEMP) {
+    etaSeconds = COOLANT_TREND_ETA_MAX_S;
+    return;
+  }
+
+  // Project from the fitted line at the newest sample (tenths of °C), not the
+  // last 1°C-quantised reading: fitted = Sy/n + slope * (n-1)/2
+  long fittedX10 = divideRounded(10 * sumY, n) + divideRounded(5 * numerator * (n - 1), denominator);
+  long remainingX10 = max(10L * COOLANT_TREND_CRITICAL_TEMP - fittedX10, 0L);
+  etaSeconds = min(remainingX10 * 60 / rateX10, (long)COOLANT_TREND_ETA_MAX_S);
+}
+
+void initializeCoolantTrend() {
+  resetTrend();
+  rateX10 = 0;
+  etaSeconds = COOLANT_TREND_ETA_MAX_S;
+}
+
+/**
+ * Add the current coolant temperature to the window and update the estimate
+ * Called by the channel registry every COOLANT_TREND_SAMPLE_MS.
+ * @return Rate of change in tenths of °C per minute
+ */
+int readCoolantTemperatureRate() {
+  // A sensor fault would put garbage in the window: start over once it clears
+  if (!isChannelValid(CHANNEL_COOLANT)) {
+    resetTrend();
+    updateEstimate(0);
+    return rateX10;
+  }
+
+  int temperature = getChannelValue(CHANNEL_COOLANT);
+  addSample(temperature);
+  updateEstimate(temperature);
+  return rateX10;
+}
+
+/**
+ * Projected time until the coolant reaches COOLANT_TREND_CRITICAL_TEMP
+ * Must be read after readCoolantTemperatureRate().
+ * @return Seconds, 0 when already critical, COOLANT_TREND_ETA_MAX_S when not rising
+ */
+int readCoolantTimeToCritical() {
+  return etaSeconds;
+}
+
+/**
+ * Overheat predicted: the TEMP_ETA channel is at or below its alarm threshold
+ */
+bool isCoolantOverheatPredicted() {
+  return isChannelInAlarm(CHANNEL_TEMP_ETA);
+}
@@ -0,0 +1,21 @@
+#ifndef COOLANT_TREND_H
+#define COOLANT_TREND_H
+
+#include <Arduino.h>
+
+// Coolant trend configuration
+extern const uint8_t COOLANT_TREND_WINDOW;
+extern const unsigned long COOLANT_TREND_SAMPLE_MS;
+extern const uint8_t COOLANT_TREND_MIN_SAMPLES;
+extern const int COOLANT_TREND_CRITICAL_TEMP;
+extern const int COOLANT_TREND_PROJECT_MIN_TEMP;
+extern const int COOLANT_TREND_MIN_RATE_X10;
+extern const int COOLANT_TREND_ETA_MAX_S;
+
+// Coolant trend functions
+void initializeCoolantTrend();
+int readCoolantTemperatureRate();
+int readCoolantTimeToCritical();
+bool isCoolantOverheatPredicted();
+
+#endif
@@ -0,0 +1,141 @@
+#include "engine_speed.h"
+#include <util/atomic.h>
+
+// Engine speed input: alternator W terminal (or crank sensor) through a
+// transistor/opto-coupler stage into ICP1 (D8). Timer1 runs at 16MHz / 8,
+// so edges are timestamped in hardware with 0.5µs resolution.
+const uint8_t ENGINE_SPEED_PIN = 8;                 // D8: ICP1
+const uint16_t ENGINE_PULSES_PER_REV_X10 = 150;     // W terminal: 6 pole pairs x 2.5 pulley ratio
+const unsigned long ENGINE_STALL_TIMEOUT_MS = 1000; // No edge for this long = 0 RPM
+const int ENGINE_RUNNING_RPM = 400;                 // Above cranking speed
+const int ENGINE_STOPPED_RPM = 200;                 // Hysteresis for the running state
+const int ENGINE_MAX_RPM = 6000;
+
+const uint32_t TIMER1_TICKS_PER_MINUTE_X10 = 1200000000UL; // 2MHz x 60s x 10
+const uint8_t ENGINE_PERIOD_FILTER_SHIFT = 3;              // EMA over ~8 periods
+
+// Edges closer than 1.5x the maximum RPM period are treated as noise
+const uint32_t ENGINE_MIN_PERIOD_TICKS =
+    TIMER1_TICKS_PER_MINUTE_X10 / ((uint32_t)ENGINE_MAX_RPM * 3 / 2 * ENGINE_PULSES_PER_REV_X10);
+const uint32_t ENGINE_MAX_PERIOD_TICKS = ENGINE_STALL_TIMEOUT_MS * 2000UL;
+
+// Shared with the capture interrupt
+static volatile uint16_t timer1Overflows = 0;
+static volatile uint32_t lastCaptureTicks = 0;
+static volatile uint32_t periodAccumulator = 0;   // Smoothed period << ENGINE_PERIOD_FILTER_SHIFT
+static volatile unsigned long lastEdgeMillis = 0;
+static volatile bool periodValid = false;
+static volatile bool hasCapture = false;
+
+// Running state, updated whenever the speed is read
+static bool engineRunning = false;
+static unsigned long engineStartMillis = 0;
+
+ISR(TIMER1_OVF_vect) {
+  timer1Overflows++;
+}
+
+ISR(TIMER1_CAPT_vect) {
+  uint16_t capture = ICR1;
+  uint16_t overflows = timer1Overflows;
+
+  // The timer wrapped after the capture but before this interrupt ran
+  if ((TIFR1 & _BV(TOV1)) && capture < 0x8000) {
+    overflows++;
+  }
+
+  uint32_t timestamp = ((uint32_t)overflows << 16) | capture;
+  uint32_t period = timestamp - lastCaptureTicks;
+
+  if (hasCapture && period < ENGINE_MIN_PERIOD_TICKS) {
+    return; // Glitch: keep timing from the previous real edge
+  }
+
+  lastCaptureTicks = timestamp;
+  lastEdgeMillis = millis();
+
+  if (!hasCapture || period > ENGINE_MAX_PERIOD_TICKS) {
+    // First edge after start-up or a stall: nothing to measure against yet
+    hasCapture = true;
+    periodValid = false;
+    return;
+  }
+
+  if (!periodValid) {
+    periodAccumulator = period << ENGINE_PERIOD_FILTER_SHIFT;
+    periodValid = true;
+  } else {
+    periodAccumulator += period - (periodAccumulator >> ENGINE_PERIOD_FILTER_SHIFT);
+  }
+}
+
+/**
+ * Configure Timer1 for input capture on ICP1
+ */
+void initializeEngineSpeed() {
+  // Internal pull-up too, so D8 does not float on installs without the W
+  // terminal wiring (the 10kΩ external pull-up still sets the edge speed)
+  pinMode(ENGINE_SPEED_PIN, INPUT_PULLUP);
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    TCCR1A = 0;
+    TCCR1B = _BV(ICNC1) | _BV(ICES1) | _BV(CS11); // Noise canceler, rising edge, clk/8
+    TCNT1 = 0;
+    TIFR1 = _BV(ICF1) | _BV(TOV1);                // Clear pending flags
+    TIMSK1 = _BV(ICIE1) | _BV(TOIE1);
+  }
+}
+
+static void updateRunningState(int rpm) {
+  if (!engineRunning && rpm >= ENGINE_RUNNING_RPM) {
+    engineRunning = true;
+    engineStartMillis = millis();
+  } else if (engineRunning && rpm < ENGINE_STOPPED_RPM) {
+    engineRunning = false;
+  }
+}
+
+/**
+ * Read the smoothed engine speed
+ * @return Engine speed in RPM, 0 when stalled
+ */
+int readEngineSpeed() {
+  uint32_t accumulator;
+  unsigned long edgeMillis;
+  bool valid;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    accumulator = periodAccumulator;
+    edgeMillis = lastEdgeMillis;
+    valid = periodValid;
+  }
+
+  int rpm = 0;
+  if (valid && millis() - edgeMillis < ENGINE_STALL_TIMEOUT_MS) {
+    uint32_t period = accumulator >> ENGINE_PERIOD_FILTER_SHIFT;
+    rpm = TIMER1_TICKS_PER_MINUTE_X10 / (period * ENGINE_PULSES_PER_REV_X10);
+  }
+
+  updateRunningState(rpm);
+  return rpm;
+}
+
+/**
+ * Read the engine running state (for the channel registry)
+ * @return 1 if running, 0 if stopped or cranking
+ */
+int readEngineRunning() {
+  return engineRunning ? 1 : 0;
+}
+
+bool isEngineRunning() {
+  return engineRunning;
+}
+
+/**
+ * Get how long the engine has been running
+ * @return Milliseconds since the engine started, 0 if stopped
+ */
+unsigned long getEngineRunningTime() {
+  return engineRunning ? millis() - engineStartMillis : 0;
+}
@@ -0,0 +1,20 @@
+#ifndef ENGINE_SPEED_H
+#define ENGINE_SPEED_H
+
+#include <Arduino.h>
+
+// Engine speed configuration
+extern const uint8_t ENGINE_SPEED_PIN;
+extern const uint16_t ENGINE_PULSES_PER_REV_X10;
+extern const unsigned long ENGINE_STALL_TIMEOUT_MS;
+extern const int ENGINE_RUNNING_RPM;
+extern const int ENGINE_STOPPED_RPM;
+
+// Engine speed functions
+void initializeEngineSpeed();
+int readEngineSpeed();
+int readEngineRunning();
+bool isEngineRunning();
+unsigned long getEngineRunningTime();
+
+#endif
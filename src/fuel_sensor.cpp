@@ -1,4 +1,6 @@
 #include "fuel_sensor.h"
+#include "sensor_diagnostics.h"
+#include "build_profile.h"
 
 // Fuel level sensor configuration
 const int FUEL_SENSOR_PIN = A1;                    // Analog pin for fuel sensor
@@ -15,11 +17,49 @@ const int FUEL_SENSOR_MAX_PERCENTAGE = 100;        // Maximum fuel percentage
 const int FUEL_EMPTY_ADC_VALUE = 5;                // Estimated ADC value when tank is empty
 const int FUEL_FULL_ADC_VALUE = 12;                // ADC value with current fuel level (122Ω)
 
+// Oversampling and decimation
+// The sender only spans ~7 raw ADC steps, so each reading sums 4^n conversions
+// and shifts the sum right by n to gain n effective bits. This relies on the ADC
+// noise being at least ~1 LSB, which holds once the span is moved onto the 1.1V
+// internal reference (1 LSB = ~1.07mV). The internal reference varies 1.0-1.2V
+// between chips, so re-measure the calibration values when it is enabled.
+const bool FUEL_USE_INTERNAL_REFERENCE = true;     // Measure A1 against the 1.1V bandgap
+const float FUEL_INTERNAL_REFERENCE_VOLTAGE = 1.1; // Nominal internal reference voltage
+const int FUEL_OVERSAMPLE_EXTRA_BITS = 4;          // Extra effective bits from decimation
+const int FUEL_OVERSAMPLE_COUNT = 1 << (2 * FUEL_OVERSAMPLE_EXTRA_BITS); // 256 conversions per reading
+const unsigned long FUEL_REFERENCE_SETTLE_MS = 35; // AREF capacitor settling after switching to 1.1V
+const int FUEL_RESOLUTION_SAMPLES = 16;            // Readings per mode for the startup resolution report
+
+// In the main loop a reading is spread over many passes so it never blocks:
+// the reference settles without a delay(), then a few conversions run per pass.
+const unsigned long FUEL_ACQUISITION_INTERVAL_MS = 1000; // One reading per fuel channel sample
+const int FUEL_CONVERSIONS_PER_PASS = 16;          // ~1.7ms of conversions (104us each) per loop pass
+
+// Calibration values in the oversampled domain (derived from the 5V raw values above)
+const float FUEL_REFERENCE_GAIN = FUEL_USE_INTERNAL_REFERENCE ? (5.0 / FUEL_INTERNAL_REFERENCE_VOLTAGE) : 1.0;
+const int FUEL_EMPTY_OVERSAMPLED_VALUE = (int)(FUEL_EMPTY_ADC_VALUE * FUEL_REFERENCE_GAIN * (1 << FUEL_OVERSAMPLE_EXTRA_BITS));
+const int FUEL_FULL_OVERSAMPLED_VALUE = (int)(FUEL_FULL_ADC_VALUE * FUEL_REFERENCE_GAIN * (1 << FUEL_OVERSAMPLE_EXTRA_BITS));
+
 // Filtering for stable readings
 const int FUEL_FILTER_SIZE = 5;                    // Number of samples for averaging
 int fuelReadings[FUEL_FILTER_SIZE];
 int fuelReadingIndex = 0;
 bool fuelFilterInitialized = false;
+static unsigned long fuelLastAcquisitionMicros = 0; // Duration of the last oversampled reading
+static int fuelLastOversampledValue = 0;            // Latest reading, shared with diagnostics
+
+// Non-blocking acquisition state
+enum FuelAcquisitionState {
+  FUEL_ACQUISITION_IDLE,
+  FUEL_ACQUISITION_SETTLING,   // Reference switched, waiting for AREF to settle
+  FUEL_ACQUISITION_CONVERTING  // Summing FUEL_CONVERSIONS_PER_PASS conversions per pass
+};
+static uint8_t fuelAcquisitionState = FUEL_ACQUISITION_IDLE;
+static unsigned long fuelAcquisitionStart = 0;      // When the current reading was started
+static unsigned long fuelAcquisitionSum = 0;
+static int fuelAcquisitionCount = 0;
+static int fuelCompletedValue = 0;                  // Newest finished reading, not yet filtered
+static bool fuelCompletedPending = false;
 
 /**
  * Initialize the fuel level sensor
@@ -33,9 +73,15 @@ void initializeFuelSensor() {
   }
   fuelFilterInitialized = false;
   
-  // Take initial reading to stabilize
+  // Take initial reading to stabilize (blocking is fine during setup)
   delay(100);
+  fuelCompletedValue = readFuelSensorOversampled();
+  fuelCompletedPending = true;
+  fuelAcquisitionStart = millis();
   readFuelLevel();
+#if ECU_FEATURE_DEBUG_LOG
+  reportFuelSensorResolution();
+#endif
 }
 
 /**
@@ -46,22 +92,236 @@ int readFuelSensorRaw() {
   return analogRead(FUEL_SENSOR_PIN);
 }
 
+/**
+ * Read fuel sensor with oversampling and decimation (blocking, ~64ms)
+ * Used during setup only; the main loop uses handleFuelSensor().
+ * Temporarily switches to the internal reference when enabled and restores
+ * the default (AVCC) reference for the other analog channels afterwards.
+ * @return Oversampled ADC value (0 to 1023 << FUEL_OVERSAMPLE_EXTRA_BITS)
+ */
+int readFuelSensorOversampled() {
+  unsigned long startMicros = micros();
+
+  if (FUEL_USE_INTERNAL_REFERENCE) {
+    analogReference(INTERNAL);
+    analogRead(FUEL_SENSOR_PIN); // Applies the new reference, result discarded
+    delay(FUEL_REFERENCE_SETTLE_MS);
+  }
+
+  unsigned long sum = 0;
+  for (int i = 0; i < FUEL_OVERSAMPLE_COUNT; i++) {
+    sum += analogRead(FUEL_SENSOR_PIN);
+  }
+
+  if (FUEL_USE_INTERNAL_REFERENCE) {
+    analogReference(DEFAULT);
+    analogRead(FUEL_SENSOR_PIN); // Restore AVCC reference, result discarded
+  }
+
+  fuelLastAcquisitionMicros = micros() - startMicros;
+
+  // Decimate: 4^n samples summed, shifted right by n
+  return (int)(sum >> FUEL_OVERSAMPLE_EXTRA_BITS);
+}
+
+/**
+ * Advance the non-blocking oversampled acquisition by one step
+ * Call once per loop. Starts a reading every FUEL_ACQUISITION_INTERVAL_MS,
+ * waits out the reference settling across passes, then runs at most
+ * FUEL_CONVERSIONS_PER_PASS conversions per pass. The finished reading is
+ * picked up by readFuelLevel().
+ */
+void handleFuelSensor() {
+  switch (fuelAcquisitionState) {
+    case FUEL_ACQUISITION_IDLE:
+      if (millis() - fuelAcquisitionStart < FUEL_ACQUISITION_INTERVAL_MS) {
+        return;
+      }
+      fuelAcquisitionStart = millis();
+      fuelAcquisitionSum = 0;
+      fuelAcquisitionCount = 0;
+      if (FUEL_USE_INTERNAL_REFERENCE) {
+        analogReference(INTERNAL);
+        analogRead(FUEL_SENSOR_PIN); // Applies the new reference, result discarded
+        fuelAcquisitionState = FUEL_ACQUISITION_SETTLING;
+      } else {
+        fuelAcquisitionState = FUEL_ACQUISITION_CONVERTING;
+      }
+      return;
+
+    case FUEL_ACQUISITION_SETTLING:
+      if (millis() - fuelAcquisitionStart >= FUEL_REFERENCE_SETTLE_MS) {
+        fuelAcquisitionState = FUEL_ACQUISITION_CONVERTING;
+      }
+      return;
+
+    case FUEL_ACQUISITION_CONVERTING:
+      for (int i = 0; i < FUEL_CONVERSIONS_PER_PASS && fuelAcquisitionCount < FUEL_OVERSAMPLE_COUNT; i++) {
+        fuelAcquisitionSum += analogRead(FUEL_SENSOR_PIN);
+        fuelAcquisitionCount++;
+      }
+      if (fuelAcquisitionCount < FUEL_OVERSAMPLE_COUNT) {
+        return;
+      }
+
+      if (FUEL_USE_INTERNAL_REFERENCE) {
+        analogReference(DEFAULT);
+        analogRead(FUEL_SENSOR_PIN); // Restore AVCC reference, result discarded
+      }
+      fuelCompletedValue = (int)(fuelAcquisitionSum >> FUEL_OVERSAMPLE_EXTRA_BITS);
+      fuelCompletedPending = true;
+      fuelAcquisitionState = FUEL_ACQUISITION_IDLE;
+      return;
+  }
+}
+
+/**
+ * Check whether an acquisition has the ADC on the 1.1V reference
+ * Other analog readings taken meanwhile would be scaled wrongly.
+ * @return true from the reference switch until AVCC is restored
+ */
+bool isFuelSensorHoldingReference() {
+  return FUEL_USE_INTERNAL_REFERENCE && fuelAcquisitionState != FUEL_ACQUISITION_IDLE;
+}
+
+/**
+ * Get the duration of the last oversampled acquisition
+ * @return Acquisition time in microseconds (including reference settling)
+ */
+unsigned long getFuelAcquisitionTimeMicros() {
+  return fuelLastAcquisitionMicros;
+}
+
+#if ECU_FEATURE_DEBUG_LOG
+// Spread of repeated readings taken by reportFuelSensorResolution()
+struct FuelReadingSpread {
+  long sum;
+  int minimum;
+  int maximum;
+};
+
+static void resetSpread(FuelReadingSpread& spread) {
+  spread.sum = 0;
+  spread.minimum = 32767;
+  spread.maximum = -32767;
+}
+
+static void addToSpread(FuelReadingSpread& spread, int value) {
+  spread.sum += value;
+  spread.minimum = min(spread.minimum, value);
+  spread.maximum = max(spread.maximum, value);
+}
+
+static void printSpread(const char* label, const FuelReadingSpread& spread) {
+  Serial.print(label);
+  Serial.print(" mean ");
+  Serial.print((float)spread.sum / FUEL_RESOLUTION_SAMPLES, 1);
+  Serial.print(" spread ");
+  Serial.print(spread.maximum - spread.minimum);
+}
+
+/**
+ * Measure the resolution gain over serial
+ * Takes FUEL_RESOLUTION_SAMPLES readings in each mode: single conversions
+ * against 5V, single conversions against the 1.1V reference, and oversampled
+ * readings. The reference gain is the measured ratio of the 1.1V and 5V
+ * means (the bandgap varies between chips). The decimation gain is how much
+ * smaller the oversampled spread is than the single-conversion spread on the
+ * same scale. It is only real if the single conversions show noise.
+ */
+void reportFuelSensorResolution() {
+  FuelReadingSpread raw, reference, oversampled;
+  resetSpread(raw);
+  resetSpread(reference);
+  resetSpread(oversampled);
+
+  for (int i = 0; i < FUEL_RESOLUTION_SAMPLES; i++) {
+    addToSpread(raw, readFuelSensorRaw());
+  }
+
+  if (FUEL_USE_INTERNAL_REFERENCE) {
+    analogReference(INTERNAL);
+    analogRead(FUEL_SENSOR_PIN);
+    delay(FUEL_REFERENCE_SETTLE_MS);
+  }
+  for (int i = 0; i < FUEL_RESOLUTION_SAMPLES; i++) {
+    addToSpread(reference, readFuelSensorRaw());
+  }
+  if (FUEL_USE_INTERNAL_REFERENCE) {
+    analogReference(DEFAULT);
+    analogRead(FUEL_SENSOR_PIN);
+  }
+
+  for (int i = 0; i < FUEL_RESOLUTION_SAMPLES; i++) {
+    addToSpread(oversampled, readFuelSensorOversampled());
+  }
+
+  Serial.print("Fuel ADC x");
+  Serial.print(FUEL_RESOLUTION_SAMPLES);
+  printSpread(": 5V", raw);
+  printSpread(FUEL_USE_INTERNAL_REFERENCE ? ", 1.1V" : ", 5V", reference);
+  printSpread(", oversampled", oversampled);
+  Serial.println();
+
+  Serial.print("Fuel ADC gain: reference ");
+  if (raw.sum > 0 && reference.sum > 0) {
+    float referenceGain = (float)reference.sum / raw.sum;
+    Serial.print(log(referenceGain) / log(2.0), 1);
+    Serial.print(" bits (x");
+    Serial.print(referenceGain, 2);
+    Serial.print(")");
+  } else {
+    Serial.print("n/a (reading 0)");
+  }
+
+  Serial.print(", decimation ");
+  int referenceSpread = reference.maximum - reference.minimum;
+  if (referenceSpread == 0) {
+    Serial.print("n/a (no ADC noise to average)");
+  } else {
+    // Single-conversion spread on the oversampled scale vs the oversampled spread
+    float ratio = (float)referenceSpread * (1 << FUEL_OVERSAMPLE_EXTRA_BITS) /
+                  max(oversampled.maximum - oversampled.minimum, 1);
+    Serial.print(log(ratio) / log(2.0), 1);
+    Serial.print(" bits");
+  }
+  Serial.print(", acquisition ");
+  Serial.print(fuelLastAcquisitionMicros);
+  Serial.println("us");
+}
+#endif
+
 /**
  * Read fuel level percentage with filtering
+ * Adds the newest reading finished by handleFuelSensor() to the filter,
+ * without converting anything itself.
  * @return Fuel level percentage (0-100)
  */
 int readFuelLevel() {
-  // Read raw ADC value
-  int rawValue = readFuelSensorRaw();
-  
-  // Add to filter array
-  fuelReadings[fuelReadingIndex] = rawValue;
-  fuelReadingIndex = (fuelReadingIndex + 1) % FUEL_FILTER_SIZE;
-  
-  // Calculate average if filter is initialized
-  if (!fuelFilterInitialized) {
-    fuelFilterInitialized = true;
-    return mapFuelLevel(rawValue);
+  if (fuelCompletedPending) {
+    fuelCompletedPending = false;
+    int rawValue = fuelCompletedValue;
+    fuelLastOversampledValue = rawValue;
+
+    // A rail reading (open or short circuit) never enters the average;
+    // the next good reading starts the filter over
+    if (!isSensorSampleInRange(DIAG_CHANNEL_FUEL, rawValue)) {
+      fuelFilterInitialized = false;
+      return mapFuelLevel(rawValue);
+    }
+
+    // The first good reading fills the whole filter
+    if (!fuelFilterInitialized) {
+      for (int i = 0; i < FUEL_FILTER_SIZE; i++) {
+        fuelReadings[i] = rawValue;
+      }
+      fuelFilterInitialized = true;
+      return mapFuelLevel(rawValue);
+    }
+
+    // Add to filter array
+    fuelReadings[fuelReadingIndex] = rawValue;
+    fuelReadingIndex = (fuelReadingIndex + 1) % FUEL_FILTER_SIZE;
   }
   
   // Calculate average of filtered readings
@@ -75,21 +335,29 @@ int readFuelLevel() {
 }
 
 /**
- * Map ADC value to fuel percentage
- * @param adcValue Raw ADC value (0-1023)
+ * Get the oversampled ADC value of the latest filtered reading
+ * @return Oversampled ADC value, without triggering a conversion
+ */
+int getLastFuelSensorOversampled() {
+  return fuelLastOversampledValue;
+}
+
+/**
+ * Map oversampled ADC value to fuel percentage
+ * @param adcValue Oversampled ADC value (see readFuelSensorOversampled)
  * @return Fuel percentage (0-100)
  */
 int mapFuelLevel(int adcValue) {
   // Clamp ADC value to expected range
-  if (adcValue < FUEL_EMPTY_ADC_VALUE) {
-    adcValue = FUEL_EMPTY_ADC_VALUE;
+  if (adcValue < FUEL_EMPTY_OVERSAMPLED_VALUE) {
+    adcValue = FUEL_EMPTY_OVERSAMPLED_VALUE;
   }
-  if (adcValue > FUEL_FULL_ADC_VALUE) {
-    adcValue = FUEL_FULL_ADC_VALUE;
+  if (adcValue > FUEL_FULL_OVERSAMPLED_VALUE) {
+    adcValue = FUEL_FULL_OVERSAMPLED_VALUE;
   }
   
   // Map ADC value to percentage
-  int percentage = map(adcValue, FUEL_EMPTY_ADC_VALUE, FUEL_FULL_ADC_VALUE, 
+  int percentage = map(adcValue, FUEL_EMPTY_OVERSAMPLED_VALUE, FUEL_FULL_OVERSAMPLED_VALUE, 
                        FUEL_SENSOR_MIN_PERCENTAGE, FUEL_SENSOR_MAX_PERCENTAGE);
   
   // Ensure percentage is within valid range
@@ -131,20 +399,14 @@ void calibrateFuelSensorFull() {
 }
 
 /**
- * Get fuel sensor status
- * @return true if sensor is working properly, false if there's an issue
+ * Get fuel sensor status from the diagnostics stage
+ * @return true if sensor is working properly, false if a fault is active
  */
 bool getFuelSensorStatus() {
-  float voltage = readFuelSensorVoltage();
-  
-  // Check if voltage is within expected range
-  if (voltage < 0.1 || voltage > 4.9) {
-    return false; // Sensor disconnected or faulty
-  }
-  
-  return true;
+  return !isSensorFaultActive(DIAG_CHANNEL_FUEL);
 }
 
+#if ECU_FEATURE_DESCRIPTIONS
 /**
  * Get fuel level description
  * @param percentage Fuel percentage (0-100)
@@ -163,3 +425,4 @@ String getFuelLevelDescription(int percentage) {
     return "FULL";
   }
 }
+#endif
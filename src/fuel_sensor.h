@@ -2,6 +2,7 @@
 #define FUEL_SENSOR_H
 
 #include <Arduino.h>
+#include "build_profile.h"
 
 // Fuel sensor configuration constants
 extern const int FUEL_SENSOR_PIN;
@@ -14,18 +15,40 @@ extern const int FUEL_SENSOR_MAX_PERCENTAGE;
 extern const int FUEL_EMPTY_ADC_VALUE;
 extern const int FUEL_FULL_ADC_VALUE;
 
+// Oversampling constants
+extern const bool FUEL_USE_INTERNAL_REFERENCE;
+extern const float FUEL_INTERNAL_REFERENCE_VOLTAGE;
+extern const int FUEL_OVERSAMPLE_EXTRA_BITS;
+extern const int FUEL_OVERSAMPLE_COUNT;
+extern const unsigned long FUEL_REFERENCE_SETTLE_MS;
+extern const int FUEL_RESOLUTION_SAMPLES;
+extern const unsigned long FUEL_ACQUISITION_INTERVAL_MS;
+extern const int FUEL_CONVERSIONS_PER_PASS;
+extern const int FUEL_EMPTY_OVERSAMPLED_VALUE;
+extern const int FUEL_FULL_OVERSAMPLED_VALUE;
+
 // Filtering constants
 extern const int FUEL_FILTER_SIZE;
 
 // Fuel sensor functions
 void initializeFuelSensor();
 int readFuelSensorRaw();
+int readFuelSensorOversampled();
+void handleFuelSensor();
+bool isFuelSensorHoldingReference();
+unsigned long getFuelAcquisitionTimeMicros();
+#if ECU_FEATURE_DEBUG_LOG
+void reportFuelSensorResolution();
+#endif
 int readFuelLevel();
+int getLastFuelSensorOversampled();
 int mapFuelLevel(int adcValue);
 float readFuelSensorVoltage();
 void calibrateFuelSensorEmpty();
 void calibrateFuelSensorFull();
 bool getFuelSensorStatus();
+#if ECU_FEATURE_DESCRIPTIONS
 String getFuelLevelDescription(int percentage);
+#endif
 
 #endif
@@ -1,11 +1,15 @@
 #include "glow_plug.h"
-#include "communication.h"
+#include "channel_registry.h"
+#include "build_profile.h"
 
 // Glow plug configuration
 const unsigned long GLOW_TIME_SECONDS = 10;
 const int GLOW_PLUG_TRANSISTOR_PIN = 2; // D2: GREEN
 const int GLOW_PLUG_BUTTON_PIN = 3; // D3: RED
 const unsigned long GLOW_SWITCH_DEBOUNCE_MS = 100;
+#if ECU_FEATURE_LCD
+const unsigned long GLOW_LONG_PRESS_MS = 1000; // Holding the button this long cycles LCD pages
+#endif
 
 // Glow plug state variables
 static int glowLastButtonState = HIGH; // The previous reading from the input pin
@@ -13,6 +17,11 @@ static unsigned long glowLastDebounceTime = 0; // The last time the output pin w
 static bool glowPlugIsActive = false;
 static unsigned long glowEndTime = 0; // When the glow plug will be disabled
 static bool buttonPressed = false; // Track if button is currently being pressed
+#if ECU_FEATURE_LCD
+static bool longPressHandled = false; // Current press already reported as a long press
+static unsigned long buttonPressTime = 0; // When the current press was accepted
+static bool longPressPending = false; // Long press not yet consumed by the display
+#endif
 
 void setupGlowPlug() {
   // Set glow plug pin as an output
@@ -23,6 +32,35 @@ void setupGlowPlug() {
   pinMode(GLOW_PLUG_BUTTON_PIN, INPUT_PULLUP);
 }
 
+// Start the glow plug, or extend the glow time if it is already on
+static void requestGlow() {
+  unsigned long currentTime = millis();
+
+  if (!glowPlugIsActive) {
+    // Start glow plug if not active
+    glowPlugIsActive = true;
+    glowEndTime = currentTime + (GLOW_TIME_SECONDS * 1000);
+    digitalWrite(GLOW_PLUG_TRANSISTOR_PIN, HIGH); // Turn on the glow plug
+    setChannelValue(CHANNEL_GLOW, 1); // Update state and send data
+    if (FEATURE_DEBUG_LOG) {
+      Serial.print("Glow plug activated! GLOW_TIME_SECONDS = ");
+      Serial.println(GLOW_TIME_SECONDS);
+    }
+  } else {
+    // Add half the original glow time to the end time if already active
+    unsigned long timeToAdd = (GLOW_TIME_SECONDS * 1000) / 2; // Add half of 10 seconds = 5 seconds
+    glowEndTime += timeToAdd;
+    if (FEATURE_DEBUG_LOG) {
+      int remainingSeconds = (glowEndTime - currentTime) / 1000;
+      Serial.print("Glow time extended by ");
+      Serial.print(timeToAdd / 1000);
+      Serial.print("s! Remaining: ");
+      Serial.print(remainingSeconds);
+      Serial.println("s");
+    }
+  }
+}
+
 void handleGlowPlug() {
   // Read the state of the glow plug button
   int buttonState = digitalRead(GLOW_PLUG_BUTTON_PIN);
@@ -40,32 +78,33 @@ void handleGlowPlug() {
     // Check for button press (transition from HIGH to LOW)
     if (buttonState == LOW && !buttonPressed) {
       buttonPressed = true; // Mark button as pressed
-      unsigned long currentTime = millis();
-      
-      if (!glowPlugIsActive) {
-        // Start glow plug if not active
-        glowPlugIsActive = true;
-        glowEndTime = currentTime + (GLOW_TIME_SECONDS * 1000);
-        digitalWrite(GLOW_PLUG_TRANSISTOR_PIN, HIGH); // Turn on the glow plug
-        updateGlowState(true); // Update state and send data
-        Serial.print("Glow plug activated! GLOW_TIME_SECONDS = ");
-        Serial.println(GLOW_TIME_SECONDS);
-      } else {
-        // Add half the original glow time to the end time if already active
-        unsigned long timeToAdd = (GLOW_TIME_SECONDS * 1000) / 2; // Add half of 10 seconds = 5 seconds
-        glowEndTime += timeToAdd;
-        int remainingSeconds = (glowEndTime - currentTime) / 1000;
-        Serial.print("Glow time extended by ");
-        Serial.print(timeToAdd / 1000);
-        Serial.print("s! Remaining: ");
-        Serial.print(remainingSeconds);
-        Serial.println("s");
-      }
+#if ECU_FEATURE_LCD
+      longPressHandled = false;
+      buttonPressTime = millis();
+#else
+      // Without an LCD there is no long press to tell apart: glow on press
+      requestGlow();
+#endif
     }
+
+#if ECU_FEATURE_LCD
+    // Button held long enough: report a long press instead of a glow request
+    if (buttonState == LOW && buttonPressed && !longPressHandled &&
+        millis() - buttonPressTime >= GLOW_LONG_PRESS_MS) {
+      longPressHandled = true;
+      longPressPending = true;
+    }
+#endif
     
     // Check for button release (transition from LOW to HIGH)
     if (buttonState == HIGH && buttonPressed) {
       buttonPressed = false; // Mark button as released
+#if ECU_FEATURE_LCD
+      // A short press acts on release, once it is known not to be a long press
+      if (!longPressHandled) {
+        requestGlow();
+      }
+#endif
     }
   }
 
@@ -74,8 +113,10 @@ void handleGlowPlug() {
     if (millis() >= glowEndTime) {
       glowPlugIsActive = false;
       digitalWrite(GLOW_PLUG_TRANSISTOR_PIN, LOW); // Turn off the glow plug
-      updateGlowState(false); // Update state and send data
-      Serial.println("Glow plug deactivated (time elapsed).");
+      setChannelValue(CHANNEL_GLOW, 0); // Update state and send data
+      if (FEATURE_DEBUG_LOG) {
+        Serial.println("Glow plug deactivated (time elapsed).");
+      }
     }
   }
 
@@ -99,3 +140,21 @@ int getRemainingGlowTime() {
   
   return (glowEndTime - currentTime) / 1000; // Return remaining seconds
 }
+
+#if ECU_FEATURE_LCD
+/**
+ * Check for a long press on the glow plug button
+ * @return true once per long press
+ */
+bool consumeButtonLongPress() {
+  bool pending = longPressPending;
+  longPressPending = false;
+  return pending;
+}
+#endif
+
+// Emergency shutdown used by the watchdog supervisor (interrupt safe, no serial output)
+void forceGlowPlugOff() {
+  digitalWrite(GLOW_PLUG_TRANSISTOR_PIN, LOW);
+  glowPlugIsActive = false;
+}
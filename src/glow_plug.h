@@ -2,17 +2,25 @@
 #define GLOW_PLUG_H
 
 #include <Arduino.h>
+#include "build_profile.h"
 
 // Glow plug configuration
 extern const unsigned long GLOW_TIME_SECONDS;
 extern const int GLOW_PLUG_TRANSISTOR_PIN;
 extern const int GLOW_PLUG_BUTTON_PIN;
 extern const unsigned long GLOW_SWITCH_DEBOUNCE_MS;
+#if ECU_FEATURE_LCD
+extern const unsigned long GLOW_LONG_PRESS_MS;
+#endif
 
 // Glow plug functions
 void setupGlowPlug();
 void handleGlowPlug();
 bool isGlowPlugActive();
 int getRemainingGlowTime();
+void forceGlowPlugOff();
+#if ECU_FEATURE_LCD
+bool consumeButtonLongPress();
+#endif
 
 #endif
@@ -1,24 +1,345 @@
 #include "lcd_display.h"
 #include "glow_plug.h"
 #include "oil_pressure.h"
-#include "temperature_sensor.h"
+#include "coolant_trend.h"
+#include "sensor_diagnostics.h"
+#include "communication.h"
+
+#if ECU_FEATURE_LCD
 
 // I2C LCD configuration (only 2 pins: SDA=A4, SCL=A5)
 const int LCD_I2C_ADDRESS = 0x27; // Common I2C address for LCD modules
+const uint8_t LCD_COLUMNS = 16;
+const uint8_t LCD_ROWS = 2;
 
 // Initialize I2C LCD object (16 columns, 2 rows)
-LiquidCrystal_I2C lcd(LCD_I2C_ADDRESS, 16, 2);
+LiquidCrystal_I2C lcd(LCD_I2C_ADDRESS, LCD_COLUMNS, LCD_ROWS);
 
-// Display update timing and state tracking
-const unsigned long LCD_UPDATE_INTERVAL_MS = 1000; // Check for updates every 1 second
+// Refresh timing and render budget
+// Each refresh sends at most LCD_MAX_BYTES_PER_REFRESH HD44780 bytes (cursor
+// moves count as one byte), so a full repaint spreads over two refreshes and
+// an I2C refresh never blocks the loop for more than ~10ms.
+const unsigned long LCD_REFRESH_INTERVAL_MS = 250;
+const uint8_t LCD_MAX_BYTES_PER_REFRESH = 18;
 static unsigned long lastLCDUpdate = 0;
-static bool firstUpdate = true; // Force first update to happen
 
-// Track previous values to detect changes
-static bool lastOilLow = false;
-static bool lastGlowActive = false;
-static int lastTemperature = 0;
-static int lastRemainingGlowTime = 0;
+// CGRAM glyphs for bar graphs: 1 to 4 lit pixel columns (0xFF is the ROM full block)
+const uint8_t LCD_GLYPH_FULL_BLOCK = 0xFF;
+const uint8_t LCD_BAR_STEPS_PER_CELL = 5;
+static const uint8_t barGlyphs[4][8] PROGMEM = {
+  { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 },
+  { 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18 },
+  { 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C },
+  { 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E }
+};
+
+// Static page templates, dynamic fields are written over them
+static const char mainTemplate[] PROGMEM        = "OIL         TEMP"
+                                                  "                ";
+static const char channelTemplate[] PROGMEM     = "                "
+                                                  "                ";
+static const char statisticsTemplate[] PROGMEM  = "         ..     "
+                                                  "         ..     ";
+static const char diagnosticsTemplate[] PROGMEM = "DTC ACTIVE:     "
+                                                  "                ";
+static const char oilAlarmTemplate[] PROGMEM    = "!!    OIL     !!"
+                                                  "!!PRESSURE LOW!!";
+static const char overheatTemplate[] PROGMEM    = "OVERHEAT IN  :  "
+                                                  "    C       /min";
+
+static_assert(sizeof(mainTemplate) == 33 && sizeof(channelTemplate) == 33 &&
+              sizeof(statisticsTemplate) == 33 && sizeof(diagnosticsTemplate) == 33 &&
+              sizeof(oilAlarmTemplate) == 33 && sizeof(overheatTemplate) == 33, "page templates must be exactly 2 x 16 characters");
+
+// Frame being composed and what the LCD currently shows
+static char frame[LCD_ROWS][LCD_COLUMNS];
+static char shown[LCD_ROWS][LCD_COLUMNS];
+static uint8_t cursorRow = 0xFF; // Unknown until the first setCursor
+static uint8_t cursorColumn = 0;
+
+// Channels with a display range, in table order
+static uint8_t displayChannels[CHANNEL_COUNT];
+static uint8_t displayChannelCount = 0;
+static uint8_t currentPage = 0;
+
+// Min/max history of valid published values since power-up
+static bool statisticsValid[CHANNEL_COUNT];
+static int statisticsMin[CHANNEL_COUNT];
+static int statisticsMax[CHANNEL_COUNT];
+
+static void loadTemplate(PGM_P pageTemplate) {
+  memcpy_P(frame, pageTemplate, sizeof(frame));
+}
+
+static void writeText(uint8_t row, uint8_t column, const char* text) {
+  while (*text && column < LCD_COLUMNS) {
+    frame[row][column++] = *text++;
+  }
+}
+
+// Copy a flash string into the frame, at most maxLength characters
+static void writeText_P(uint8_t row, uint8_t column, PGM_P text, uint8_t maxLength) {
+  char c;
+  while (maxLength-- > 0 && column < LCD_COLUMNS && (c = pgm_read_byte(text++)) != '\0') {
+    frame[row][column++] = c;
+  }
+}
+
+// Right-align a number in a field, '*' if it does not fit
+// decimals = 1 prints a value in tenths as "13.8"
+static void writeNumber(uint8_t row, uint8_t column, uint8_t width, int value, uint8_t decimals = 0) {
+  char digits[8];
+  if (decimals == 0) {
+    itoa(value, digits, 10);
+  } else {
+    int whole = value / 10;
+    snprintf(digits, sizeof(digits), "%s%d.%d", (value < 0 && whole == 0) ? "-" : "", whole, abs(value % 10));
+  }
+  uint8_t length = strlen(digits);
+
+  for (uint8_t i = 0; i < width; i++) {
+    char c = ' ';
+    if (length > width) {
+      c = '*';
+    } else if (i >= width - length) {
+      c = digits[i - (width - length)];
+    }
+    frame[row][column + i] = c;
+  }
+}
+
+// Draw a full-width bar graph on one row
+static void writeBar(uint8_t row, int value, int minValue, int maxValue) {
+  long steps = (long)(constrain(value, minValue, maxValue) - minValue) *
+               (LCD_COLUMNS * LCD_BAR_STEPS_PER_CELL) / (maxValue - minValue);
+
+  for (uint8_t column = 0; column < LCD_COLUMNS; column++) {
+    int cellSteps = steps - column * LCD_BAR_STEPS_PER_CELL;
+    if (cellSteps >= LCD_BAR_STEPS_PER_CELL) {
+      frame[row][column] = LCD_GLYPH_FULL_BLOCK;
+    } else if (cellSteps > 0) {
+      frame[row][column] = cellSteps; // CGRAM slots 1-4
+    } else {
+      frame[row][column] = ' ';
+    }
+  }
+}
+
+static void trackStatistics(const SensorState& state) {
+  for (uint8_t i = 0; i < displayChannelCount; i++) {
+    uint8_t id = displayChannels[i];
+    if (!isChannelValid((ChannelId)id)) {
+      continue;
+    }
+
+    int value = state.values[id];
+    if (!statisticsValid[id]) {
+      statisticsMin[id] = statisticsMax[id] = value;
+      statisticsValid[id] = true;
+    }
+    statisticsMin[id] = min(statisticsMin[id], value);
+    statisticsMax[id] = max(statisticsMax[id], value);
+  }
+}
+
+static void composeMainPage(const SensorState& state) {
+  writeText(1, 0, isOilLow() ? "LOW " : "OK  ");
+
+  uint16_t faultCode = getActiveFaultCode(0);
+  if (isGlowPlugActive()) {
+    writeText(0, 6, "GLOW");
+    int remaining = getRemainingGlowTime();
+    if (remaining > 0) {
+      writeNumber(1, 6, 3, remaining);
+      writeText(1, 9, "s");
+    } else {
+      writeText(1, 6, "ON");
+    }
+  } else if (faultCode != 0) {
+    char codeStr[DTC_STRING_LENGTH];
+    formatTroubleCode(faultCode, codeStr);
+    writeText(0, 6, "DTC");
+    writeText(1, 6, codeStr);
+  }
+
+  if (isChannelValid(CHANNEL_COOLANT)) {
+    writeNumber(1, 11, 4, state.values[CHANNEL_COOLANT]);
+    writeText(1, 15, "C");
+  } else {
+    writeText(1, 13, "ERR");
+  }
+}
+
+// Tag and value on the top row, bar graph over the display range below
+static void composeChannelPage(uint8_t id, const SensorState& state) {
+  ChannelDescriptor descriptor;
+  getChannelDescriptor((ChannelId)id, descriptor);
+  writeText_P(0, 0, descriptor.tag, 10);
+
+  if (isChannelValid((ChannelId)id)) {
+    int value = state.values[id];
+    writeNumber(0, 10, 5, value, descriptor.decimals);
+    frame[0][15] = descriptor.unit;
+    writeBar(1, value, descriptor.displayMin, descriptor.displayMax);
+  } else {
+    writeText(0, 12, "ERR");
+    writeText(1, 0, "SENSOR FAULT");
+  }
+}
+
+// One displayed channel per row: label, min..max, unit
+static void composeStatisticsPage(uint8_t firstIndex) {
+  for (uint8_t row = 0; row < LCD_ROWS; row++) {
+    uint8_t index = firstIndex + row;
+    if (index >= displayChannelCount) {
+      writeText(row, 9, "  ");
+      continue;
+    }
+
+    uint8_t id = displayChannels[index];
+    ChannelDescriptor descriptor;
+    getChannelDescriptor((ChannelId)id, descriptor);
+    writeText_P(row, 0, descriptor.tag, 4);
+    frame[row][15] = descriptor.unit;
+
+    if (statisticsValid[id]) {
+      writeNumber(row, 5, 4, statisticsMin[id], descriptor.decimals);
+      writeNumber(row, 11, 4, statisticsMax[id], descriptor.decimals);
+    } else {
+      writeText(row, 7, "--");
+      writeText(row, 11, "--");
+    }
+  }
+}
+
+static void composeDiagnosticsPage() {
+  int count = getActiveFaultCount();
+  writeNumber(0, 12, 3, count);
+
+  if (count == 0) {
+    writeText(1, 0, "NO FAULTS");
+    return;
+  }
+
+  // Room for two codes, then a "+n" overflow marker
+  char codeStr[DTC_STRING_LENGTH];
+  for (int i = 0; i < count && i < 2; i++) {
+    formatTroubleCode(getActiveFaultCode(i), codeStr);
+    writeText(1, i * 6, codeStr);
+  }
+  if (count > 2) {
+    writeText(1, 12, "+");
+    writeNumber(1, 13, 2, count - 2);
+  }
+}
+
+// Countdown to critical coolant temperature, with the trend behind it
+static void composeOverheatPage() {
+  int eta = getChannelValue(CHANNEL_TEMP_ETA);
+  if (eta == 0) {
+    writeText(0, 0, "COOLANT CRITICAL");
+  } else {
+    writeNumber(0, 11, 2, eta / 60); // Minutes in columns 11-12, ':' in column 13
+    frame[0][14] = '0' + (eta % 60) / 10;
+    frame[0][15] = '0' + eta % 10;
+  }
+  writeNumber(1, 0, 4, getChannelValue(CHANNEL_COOLANT));
+  writeNumber(1, 6, 6, getChannelValue(CHANNEL_TEMP_RATE), 1);
+}
+
+static uint8_t getStatisticsPageCount() {
+  return (displayChannelCount + LCD_ROWS - 1) / LCD_ROWS;
+}
+
+uint8_t getLCDPageCount() {
+  return 1 + displayChannelCount + getStatisticsPageCount() + 1;
+}
+
+// Resolve a page number into its kind and the kind-relative index
+static LcdPageKind getPageKind(uint8_t page, uint8_t& index) {
+  if (page == 0) {
+    return LCD_PAGE_MAIN;
+  }
+  page -= 1;
+  if (page < displayChannelCount) {
+    index = page;
+    return LCD_PAGE_CHANNEL;
+  }
+  page -= displayChannelCount;
+  if (page < getStatisticsPageCount()) {
+    index = page * LCD_ROWS;
+    return LCD_PAGE_STATISTICS;
+  }
+  return LCD_PAGE_DIAGNOSTICS;
+}
+
+// Compose the page that should be on screen now into frame
+static void composeFrame() {
+  SensorState state = getPublishedSensorState();
+  trackStatistics(state);
+
+  // Low oil pressure with the engine running takes over the screen whatever page is selected
+  if (isOilPressureAlarm()) {
+    loadTemplate(oilAlarmTemplate);
+    return;
+  }
+
+  // Then a projected overheat, minutes before the coolant alarm itself
+  if (isCoolantOverheatPredicted()) {
+    loadTemplate(overheatTemplate);
+    composeOverheatPage();
+    return;
+  }
+
+  uint8_t index = 0;
+  switch (getPageKind(currentPage, index)) {
+    case LCD_PAGE_MAIN:
+      loadTemplate(mainTemplate);
+      composeMainPage(state);
+      break;
+    case LCD_PAGE_CHANNEL:
+      loadTemplate(channelTemplate);
+      composeChannelPage(displayChannels[index], state);
+      break;
+    case LCD_PAGE_STATISTICS:
+      loadTemplate(statisticsTemplate);
+      composeStatisticsPage(index);
+      break;
+    case LCD_PAGE_DIAGNOSTICS:
+      loadTemplate(diagnosticsTemplate);
+      composeDiagnosticsPage();
+      break;
+  }
+}
+
+// Send the characters that differ from what is shown, within the byte budget.
+// Whatever does not fit stays different and goes out on the next refresh.
+static void flushFrame() {
+  uint8_t budget = LCD_MAX_BYTES_PER_REFRESH;
+
+  for (uint8_t row = 0; row < LCD_ROWS; row++) {
+    for (uint8_t column = 0; column < LCD_COLUMNS; column++) {
+      if (frame[row][column] == shown[row][column]) {
+        continue;
+      }
+
+      bool cursorInPlace = (row == cursorRow && column == cursorColumn);
+      uint8_t cost = cursorInPlace ? 1 : 2;
+      if (cost > budget) {
+        return;
+      }
+
+      if (!cursorInPlace) {
+        lcd.setCursor(column, row);
+        cursorRow = row;
+      }
+      lcd.write((uint8_t)frame[row][column]);
+      shown[row][column] = frame[row][column];
+      cursorColumn = column + 1; // HD44780 auto-increments the address
+      budget -= cost;
+    }
+  }
+}
 
 void setupLCD() {
   // Initialize I2C communication
@@ -27,6 +348,22 @@ void setupLCD() {
   // Initialize the LCD with 16 columns and 2 rows
   lcd.init();
   lcd.backlight(); // Turn on backlight
+
+  // Channels with a display range get a bar graph and statistics
+  for (uint8_t id = 0; id < CHANNEL_COUNT; id++) {
+    ChannelDescriptor descriptor;
+    getChannelDescriptor((ChannelId)id, descriptor);
+    if (descriptor.displayMin != descriptor.displayMax) {
+      displayChannels[displayChannelCount++] = id;
+    }
+  }
+
+  // Load bar graph glyphs into CGRAM slots 1-4
+  uint8_t glyph[8];
+  for (uint8_t i = 0; i < 4; i++) {
+    memcpy_P(glyph, barGlyphs[i], sizeof(glyph));
+    lcd.createChar(i + 1, glyph);
+  }
   
   // Display startup message
   lcd.setCursor(0, 0);
@@ -38,90 +375,29 @@ void setupLCD() {
   
   // Clear display and show initial status
   lcd.clear();
+  memset(shown, ' ', sizeof(shown));
+  cursorRow = 0xFF;
+  lastLCDUpdate = millis() - LCD_REFRESH_INTERVAL_MS;
   updateLCD();
 }
 
 void updateLCD() {
-  // Check for updates every LCD_UPDATE_INTERVAL_MS milliseconds
-  // But always allow the first update to happen
-  if (!firstUpdate && millis() - lastLCDUpdate < LCD_UPDATE_INTERVAL_MS) {
+  if (consumeButtonLongPress()) {
+    showLCDPage((currentPage + 1) % getLCDPageCount());
+  }
+
+  if (millis() - lastLCDUpdate < LCD_REFRESH_INTERVAL_MS) {
     return;
   }
-  
   lastLCDUpdate = millis();
-  firstUpdate = false;
-  
-  // Get current values
-  bool currentOilLow = isOilLow();
-  bool currentGlowActive = isGlowPlugActive();
-  int currentTemperature = readTemperatureSensor();
-  int currentRemainingGlowTime = getRemainingGlowTime();
-  
-  // Check if any values have changed
-  bool needsUpdate = (currentOilLow != lastOilLow) || 
-                     (currentGlowActive != lastGlowActive) || 
-                     (currentTemperature != lastTemperature) ||
-                     (currentRemainingGlowTime != lastRemainingGlowTime);
-  
-  // Only update display if something changed
-  if (needsUpdate) {
-    // Clear the display
-    lcd.clear();
-    
-    // Display oil status on the left (first 5 characters)
-    displayOilStatus(currentOilLow);
-    
-    // Display glow plug status in the center only when active
-    if (currentGlowActive) {
-      int remainingTime = getRemainingGlowTime();
-      displayGlowPlugStatus(true, remainingTime);
-    }
-    
-    // Display temperature on the right (characters 13-15, right-aligned)
-    displayTemperature(currentTemperature);
-    
-    // Update stored values
-    lastOilLow = currentOilLow;
-    lastGlowActive = currentGlowActive;
-    lastTemperature = currentTemperature;
-    lastRemainingGlowTime = currentRemainingGlowTime;
-  }
-}
 
-void displayOilStatus(bool isLow) {
-  lcd.setCursor(0, 0);
-  lcd.print("OIL");
-  lcd.setCursor(0, 1);
-  if (isLow) {
-    lcd.print("LOW ");
-  } else {
-    lcd.print("OK  ");
-  }
+  composeFrame();
+  flushFrame();
 }
 
-void displayGlowPlugStatus(bool isActive, int remainingTime) {
-  lcd.setCursor(6, 0);
-  lcd.print("GLOW");
-  lcd.setCursor(6, 1);
-  if (isActive && remainingTime > 0) {
-    String timeStr = String(remainingTime) + "s";
-    lcd.print(timeStr);
-    // Clear any remaining characters if the time string is shorter
-    for (int i = timeStr.length(); i < 4; i++) {
-      lcd.print(" ");
-    }
-  } else {
-    lcd.print("ON  ");
-  }
+void showLCDPage(uint8_t page) {
+  currentPage = page;
+  lastLCDUpdate = millis() - LCD_REFRESH_INTERVAL_MS; // Render on the next call
 }
 
-void displayTemperature(int temperature) {
-  lcd.setCursor(12, 0);
-  lcd.print("TEMP");
-  
-  // Right-align temperature value to touch the right edge
-  String tempStr = String(temperature) + "C";
-  int startPos = 16 - tempStr.length(); // Calculate position to right-align
-  lcd.setCursor(startPos, 1);
-  lcd.print(tempStr);
-}
+#endif
@@ -2,17 +2,33 @@
 #define LCD_DISPLAY_H
 
 #include <Arduino.h>
+#include "build_profile.h"
+
+#if ECU_FEATURE_LCD
 #include <Wire.h>
 #include <LiquidCrystal_I2C.h>
 
 // I2C LCD configuration (only 2 pins: SDA and SCL)
 extern const int LCD_I2C_ADDRESS;
+extern const unsigned long LCD_REFRESH_INTERVAL_MS;
+extern const uint8_t LCD_MAX_BYTES_PER_REFRESH;
+
+// Dashboard page kinds, cycled with a long press on the glow plug button.
+// Pages: main, one bar graph page per displayed channel, statistics (two
+// channels per page), diagnostics.
+enum LcdPageKind {
+  LCD_PAGE_MAIN,
+  LCD_PAGE_CHANNEL,
+  LCD_PAGE_STATISTICS,
+  LCD_PAGE_DIAGNOSTICS
+};
 
 // LCD display functions
 void setupLCD();
 void updateLCD();
-void displayOilStatus(bool isLow);
-void displayGlowPlugStatus(bool isActive, int remainingTime = 0);
-void displayTemperature(int temperature);
+void showLCDPage(uint8_t page);
+uint8_t getLCDPageCount();
+
+#endif
 
 #endif
@@ -1,71 +1,63 @@
 #include <Arduino.h>
+#include "build_profile.h"
 #include "glow_plug.h"
 #include "oil_pressure.h"
-#include "temperature_sensor.h"
+#include "channel_registry.h"
 #include "fuel_sensor.h"
 #include "communication.h"
 #include "lcd_display.h"
-
-// Timing for sensor readings
-const unsigned long SENSOR_UPDATE_INTERVAL_MS = 1000; // 1 second
-static unsigned long lastSensorUpdateTime = 0;
-
-// Wrapper functions for compatibility with existing code
-int readCoolantSensor() {
-  return readTemperatureSensor();
-}
-
-int readFuelSensor() {
-  return readFuelLevel();
-}
-
-void initializeSensors() {
-  // Initialize individual sensor modules
-  initializeTemperatureSensor();
-  initializeFuelSensor();
-  
-  // Initialize sensor values
-  updateCoolantState(readCoolantSensor());
-  updateFuelState(readFuelSensor());
-}
-
-void updateSensors() {
-  // Read other sensors and update state every second
-  if (millis() - lastSensorUpdateTime >= SENSOR_UPDATE_INTERVAL_MS) {
-    updateCoolantState(readCoolantSensor());
-    updateFuelState(readFuelSensor());
-    
-    lastSensorUpdateTime = millis(); // Update the timer
-  }
-}
+#include "watchdog_supervisor.h"
 
 void setup() {
   // Initialize serial communication for ESP32 communication
-  Serial.begin(115200);
-  Serial.println("Engine Control Unit - Starting up...");
+  if (FEATURE_SERIAL) {
+    Serial.begin(TELEMETRY_BAUD_RATE);
+  }
+  if (FEATURE_DEBUG_LOG) {
+    Serial.println("Engine Control Unit - Starting up... (" ECU_PROFILE_NAME ")");
+  }
+  reportResetCause();
 
   // Initialize all modules
   setupGlowPlug();
   setupOilPressure();
   
-  // Initialize sensors and communication
-  initializeSensors();
+  // Initialize sensor channels and communication
+  initializeChannels();
   initializeCommunication();
   
+#if ECU_FEATURE_LCD
   // Initialize LCD display
   setupLCD();
+#endif
+  
+  // Start supervising the main loop
+  setupWatchdogSupervisor();
   
-  Serial.println("Setup complete. System ready.");
+  if (FEATURE_DEBUG_LOG) {
+    Serial.println("Setup complete. System ready.");
+  }
 }
 
 void loop() {
-  // Handle all subsystems
+  // Handle all subsystems, each timed from its taskBegin()
+  taskBegin(TASK_GLOW_PLUG);
   handleGlowPlug(); 
+  taskBegin(TASK_OIL_PRESSURE);
   handleOilPressure();
   
-  // Update sensors periodically
-  updateSensors();
+  // Sample due channels and publish their telemetry
+  taskBegin(TASK_SENSORS);
+  handleFuelSensor();
+  updateChannels();
+  serviceTelemetry();
   
+#if ECU_FEATURE_LCD
   // Update LCD display
+  taskBegin(TASK_LCD);
   updateLCD();
+#endif
+  
+  // Ends the last task, pets the watchdog only if every task met its deadline
+  serviceWatchdog();
 }
@@ -1,15 +1,19 @@
 #include "oil_pressure.h"
-#include "communication.h"
+#include "channel_registry.h"
+#include "engine_speed.h"
+#include "build_profile.h"
 
 // Oil pressure configuration
 const byte OIL_SWITCH_PIN = 4; // D4: BLUE
 const unsigned long OIL_DEBOUNCE_MS = 100;
+const unsigned long OIL_ALARM_START_DELAY_MS = 3000; // Pressure builds up after the engine starts
 
 // Oil pressure state variables
 static bool oilIsLow = false;
 static uint8_t oilLastRawReading = HIGH;
 static bool oilStableState = HIGH;          // debounced state
 static unsigned long oilLastChangeMillis = 0;
+static unsigned long oilEdgeMicros = 0;       // First raw edge away from the stable state
 
 void setupOilPressure() {
   pinMode(OIL_SWITCH_PIN, INPUT_PULLUP);  // use internal pull-up
@@ -19,7 +23,7 @@ void setupOilPressure() {
   oilStableState = oilLastRawReading;
   // With 1k/10k resistor setup: LOW = low pressure (switch closed), HIGH = normal pressure (switch open)
   oilIsLow = (oilStableState == LOW);
-  updateOilState(oilIsLow ? 1 : 0); // Initialize oil state (1 = low pressure warning, 0 = normal)
+  setChannelValue(CHANNEL_OIL, oilIsLow ? 1 : 0); // Initialize oil state (1 = low pressure warning, 0 = normal)
 
   oilLastChangeMillis = millis();
 }
@@ -29,6 +33,10 @@ void handleOilPressure() {
 
   // if input changed, reset timer
   if (raw != oilLastRawReading) {
+    // The first edge of a change, before any bounce: alarm latency starts here
+    if (oilLastRawReading == oilStableState) {
+      oilEdgeMicros = micros();
+    }
     oilLastChangeMillis = millis();
     oilLastRawReading = raw;
   } else {
@@ -39,7 +47,7 @@ void handleOilPressure() {
       oilIsLow = (oilStableState == LOW);
 
       // Update sensor state (1 = low oil pressure warning, 0 = normal oil pressure)
-      updateOilState(oilIsLow ? 1 : 0);
+      setChannelValue(CHANNEL_OIL, oilIsLow ? 1 : 0, oilEdgeMicros);
     }
   }
 }
@@ -47,3 +55,17 @@ void handleOilPressure() {
 bool isOilLow() {
   return oilIsLow;
 }
+
+/**
+ * Low oil pressure is only an alarm once the engine has been running for a
+ * moment: with the engine stopped the switch always reads low.
+ * Built without the speed input (ECU_FEATURE_SPEED_INPUT 0) the running state
+ * is unknown, so every low reading is an alarm.
+ * @return true if the driver must be warned
+ */
+bool isOilPressureAlarm() {
+  if (!FEATURE_SPEED_INPUT) {
+    return oilIsLow;
+  }
+  return oilIsLow && getEngineRunningTime() >= OIL_ALARM_START_DELAY_MS;
+}
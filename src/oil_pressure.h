@@ -6,10 +6,12 @@
 // Oil pressure configuration
 extern const byte OIL_SWITCH_PIN;
 extern const unsigned long OIL_DEBOUNCE_MS;
+extern const unsigned long OIL_ALARM_START_DELAY_MS;
 
 // Oil pressure functions
 void setupOilPressure();
 void handleOilPressure();
 bool isOilLow();
+bool isOilPressureAlarm();
 
 #endif
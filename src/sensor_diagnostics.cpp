@@ -0,0 +1,209 @@
+#include "sensor_diagnostics.h"
+#include "communication.h"
+#include "engine_speed.h"
+
+// Debounce: a failing sample adds DIAG_FAIL_WEIGHT, a passing sample removes 1.
+// A fault sets when the counter reaches DIAG_SET_THRESHOLD (3 consecutive bad
+// samples, or a sensor that keeps failing intermittently) and clears after
+// DIAG_CLEAR_SAMPLES consecutive good samples.
+const uint8_t DIAG_FAIL_WEIGHT = 2;
+const uint8_t DIAG_SET_THRESHOLD = 6;
+const uint8_t DIAG_CLEAR_SAMPLES = 10;
+
+// Only open and short make a value unusable. Stuck-at and rate faults are
+// reported as trouble codes but the value keeps flowing.
+const uint8_t DIAG_INVALIDATING_FAULTS = (1 << SENSOR_FAULT_OPEN) | (1 << SENSOR_FAULT_SHORT);
+
+// Per-channel plausibility limits, in the units the channel is sampled in
+struct DiagnosticConfig {
+  int openThreshold;          // Raw value at or above this is an open circuit
+  int shortThreshold;         // Raw value at or below this is a short to ground
+  int maxStep;                // Largest plausible change between two samples
+  unsigned int stuckSamples;  // Identical samples before stuck-at (0 = disabled)
+  int stuckRawMin;            // Stuck-at is only checked at or above this raw value
+  unsigned long stuckWindowMs; // ...and within this long after engine start (0 = while running)
+  uint16_t codes[SENSOR_FAULT_COUNT]; // Trouble codes (open, short, stuck, rate)
+};
+
+// Stuck-at needs a reading that is expected to move, so it is only checked
+// with the engine running. A steady reading is normal otherwise: a warm engine
+// held by the thermostat, or the fuel gauge with the ignition on and the
+// engine stopped.
+static const DiagnosticConfig diagnosticConfigs[DIAG_CHANNEL_COUNT] = {
+  // Coolant: 10-bit raw ADC, 7.98kΩ pull-up. -40°C reads ~810, 120°C reads ~7.
+  // Stuck-at while warming up below 60°C (raw >= 41, ~2 counts/°C), in the first
+  // 15 minutes after start: 2 minutes without a change. Near 88°C 1°C is only
+  // ~0.5 counts, so the reading is not checked there.
+  // P0118 circuit high, P0117 circuit low, P0116 range/performance, P0119 intermittent
+  { 1010, 2, 60, 120, 41, 900000UL, { 0x0118, 0x0117, 0x0116, 0x0119 } },
+  // Fuel: oversampled ADC against 1.1V, empty ~363, full ~872, open saturates at 16368.
+  // Stuck-at after 10 minutes of identical readings with the engine running
+  // (consumption, sloshing and ADC noise all move the oversampled value).
+  // P0463 circuit high, P0462 circuit low, P0461 range/performance, P0464 intermittent
+  { 16000, 100, 600, 600, 0, 0, { 0x0463, 0x0462, 0x0461, 0x0464 } }
+};
+
+// Per-channel runtime state
+struct DiagnosticState {
+  int lastRaw;
+  bool hasSample;
+  bool sampleValid;
+  unsigned int stuckRun;
+  uint8_t activeMask;
+  uint8_t failCounter[SENSOR_FAULT_COUNT];
+  uint8_t passCounter[SENSOR_FAULT_COUNT];
+};
+
+static DiagnosticState diagnosticStates[DIAG_CHANNEL_COUNT];
+
+/**
+ * Reset all diagnostic state (no faults active)
+ */
+void initializeSensorDiagnostics() {
+  for (int i = 0; i < DIAG_CHANNEL_COUNT; i++) {
+    memset(&diagnosticStates[i], 0, sizeof(DiagnosticState));
+    diagnosticStates[i].sampleValid = true;
+  }
+}
+
+/**
+ * Debounce one fault condition and report set/clear transitions
+ */
+static void debounceFault(DiagnosticChannel channel, SensorFault fault, bool failing) {
+  DiagnosticState& state = diagnosticStates[channel];
+  uint8_t bit = 1 << fault;
+  bool active = state.activeMask & bit;
+
+  if (failing) {
+    state.passCounter[fault] = 0;
+    uint8_t counter = state.failCounter[fault] + DIAG_FAIL_WEIGHT;
+    state.failCounter[fault] = counter > DIAG_SET_THRESHOLD ? DIAG_SET_THRESHOLD : counter;
+
+    if (!active && state.failCounter[fault] >= DIAG_SET_THRESHOLD) {
+      state.activeMask |= bit;
+      sendTroubleCode(diagnosticConfigs[channel].codes[fault], true);
+    }
+  } else {
+    if (state.failCounter[fault] > 0) {
+      state.failCounter[fault]--;
+    }
+
+    if (active && ++state.passCounter[fault] >= DIAG_CLEAR_SAMPLES) {
+      state.activeMask &= ~bit;
+      state.failCounter[fault] = 0;
+      state.passCounter[fault] = 0;
+      sendTroubleCode(diagnosticConfigs[channel].codes[fault], false);
+    }
+  }
+}
+
+/**
+ * Run all fault checks on a sample taken by the normal acquisition path
+ * @param channel Diagnosed channel
+ * @param rawValue Raw sample, in the channel's ADC units
+ */
+void processSensorSample(DiagnosticChannel channel, int rawValue) {
+  const DiagnosticConfig& config = diagnosticConfigs[channel];
+  DiagnosticState& state = diagnosticStates[channel];
+
+  bool open = rawValue >= config.openThreshold;
+  bool shorted = rawValue <= config.shortThreshold; // Same limits as isSensorSampleInRange()
+  bool implausibleStep = false;
+
+  if (state.hasSample) {
+    int step = rawValue - state.lastRaw;
+    implausibleStep = abs(step) > config.maxStep;
+
+    bool changeExpected = isEngineRunning() && rawValue >= config.stuckRawMin &&
+                          (config.stuckWindowMs == 0 || getEngineRunningTime() < config.stuckWindowMs);
+
+    if (changeExpected && rawValue == state.lastRaw) {
+      if (state.stuckRun < config.stuckSamples) {
+        state.stuckRun++;
+      }
+    } else {
+      state.stuckRun = 0;
+    }
+  }
+
+  bool stuck = config.stuckSamples > 0 && state.stuckRun >= config.stuckSamples;
+
+  debounceFault(channel, SENSOR_FAULT_OPEN, open);
+  debounceFault(channel, SENSOR_FAULT_SHORT, shorted);
+  debounceFault(channel, SENSOR_FAULT_STUCK, stuck);
+  debounceFault(channel, SENSOR_FAULT_RATE, implausibleStep);
+
+  // Rail readings are never passed on, even before the fault is confirmed
+  state.sampleValid = !open && !shorted;
+  state.lastRaw = rawValue;
+  state.hasSample = true;
+}
+
+/**
+ * Check a raw sample against the open and short thresholds of a channel
+ * Sensor filters use it to keep rail samples out of their averages.
+ * @return true if the sample is neither an open nor a short circuit reading
+ */
+bool isSensorSampleInRange(DiagnosticChannel channel, int rawValue) {
+  const DiagnosticConfig& config = diagnosticConfigs[channel];
+  return rawValue < config.openThreshold && rawValue > config.shortThreshold;
+}
+
+/**
+ * Check whether the latest value of a channel may be used downstream
+ * Stuck-at and rate faults are report-only and do not invalidate the value.
+ * @return true if no open/short fault is active and the latest sample is in range
+ */
+bool isSensorValueValid(DiagnosticChannel channel) {
+  const DiagnosticState& state = diagnosticStates[channel];
+  return state.sampleValid && (state.activeMask & DIAG_INVALIDATING_FAULTS) == 0;
+}
+
+/**
+ * Check whether any confirmed fault is active on a channel
+ */
+bool isSensorFaultActive(DiagnosticChannel channel) {
+  return diagnosticStates[channel].activeMask != 0;
+}
+
+/**
+ * Count confirmed faults across all channels
+ */
+int getActiveFaultCount() {
+  int count = 0;
+  for (int channel = 0; channel < DIAG_CHANNEL_COUNT; channel++) {
+    for (int fault = 0; fault < SENSOR_FAULT_COUNT; fault++) {
+      if (diagnosticStates[channel].activeMask & (1 << fault)) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+/**
+ * Get the trouble code of the n-th active fault
+ * @param index 0 to getActiveFaultCount() - 1
+ * @return Trouble code (e.g. 0x0118), or 0 if index is out of range
+ */
+uint16_t getActiveFaultCode(int index) {
+  for (int channel = 0; channel < DIAG_CHANNEL_COUNT; channel++) {
+    for (int fault = 0; fault < SENSOR_FAULT_COUNT; fault++) {
+      if (diagnosticStates[channel].activeMask & (1 << fault)) {
+        if (index-- == 0) {
+          return diagnosticConfigs[channel].codes[fault];
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * Format a trouble code as text
+ * @param code Trouble code (e.g. 0x0118)
+ * @param buffer At least DTC_STRING_LENGTH bytes, receives "P0118"
+ */
+void formatTroubleCode(uint16_t code, char* buffer) {
+  snprintf(buffer, DTC_STRING_LENGTH, "P%04X", code);
+}
@@ -0,0 +1,40 @@
+#ifndef SENSOR_DIAGNOSTICS_H
+#define SENSOR_DIAGNOSTICS_H
+
+#include <Arduino.h>
+
+// Diagnosed analog channels
+enum DiagnosticChannel {
+  DIAG_CHANNEL_COOLANT,
+  DIAG_CHANNEL_FUEL,
+  DIAG_CHANNEL_COUNT
+};
+
+// Fault types detected on each channel
+enum SensorFault {
+  SENSOR_FAULT_OPEN,   // Input pulled to the rail (sensor disconnected)
+  SENSOR_FAULT_SHORT,  // Input at ground (sensor wire shorted)
+  SENSOR_FAULT_STUCK,  // Identical raw value while a change is expected (report-only)
+  SENSOR_FAULT_RATE,   // Implausible change between samples (report-only)
+  SENSOR_FAULT_COUNT
+};
+
+// Debounce configuration
+extern const uint8_t DIAG_FAIL_WEIGHT;
+extern const uint8_t DIAG_SET_THRESHOLD;
+extern const uint8_t DIAG_CLEAR_SAMPLES;
+
+// Length of a formatted trouble code including terminator ("P0118")
+const int DTC_STRING_LENGTH = 6;
+
+// Diagnostics functions
+void initializeSensorDiagnostics();
+void processSensorSample(DiagnosticChannel channel, int rawValue);
+bool isSensorSampleInRange(DiagnosticChannel channel, int rawValue);
+bool isSensorValueValid(DiagnosticChannel channel);
+bool isSensorFaultActive(DiagnosticChannel channel);
+int getActiveFaultCount();
+uint16_t getActiveFaultCode(int index);
+void formatTroubleCode(uint16_t code, char* buffer);
+
+#endif
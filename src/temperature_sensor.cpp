@@ -1,4 +1,6 @@
 #include "temperature_sensor.h"
+#include "sensor_diagnostics.h"
+#include "build_profile.h"
 
 // Temperature sensor configuration
 const int TEMP_SENSOR_PIN = A0;                    // Analog pin for temperature sensor
@@ -21,6 +23,7 @@ const int TEMP_FILTER_SIZE = 5;                    // Number of samples for aver
 int tempReadings[TEMP_FILTER_SIZE];
 int tempReadingIndex = 0;
 bool tempFilterInitialized = false;
+static int tempLastRawValue = 0; // Latest conversion, shared with diagnostics
 
 /**
  * Initialize the temperature sensor
@@ -54,17 +57,28 @@ int readTemperatureSensorRaw() {
 int readTemperatureSensor() {
   // Read raw ADC value
   int rawValue = readTemperatureSensorRaw();
+  tempLastRawValue = rawValue;
   
-  // Add to filter array
-  tempReadings[tempReadingIndex] = rawValue;
-  tempReadingIndex = (tempReadingIndex + 1) % TEMP_FILTER_SIZE;
+  // A rail sample (open or short circuit) never enters the average;
+  // the next good sample starts the filter over
+  if (!isSensorSampleInRange(DIAG_CHANNEL_COOLANT, rawValue)) {
+    tempFilterInitialized = false;
+    return mapTemperature(rawValue);
+  }
   
-  // Calculate average if filter is initialized
+  // The first good sample fills the whole filter
   if (!tempFilterInitialized) {
+    for (int i = 0; i < TEMP_FILTER_SIZE; i++) {
+      tempReadings[i] = rawValue;
+    }
     tempFilterInitialized = true;
     return mapTemperature(rawValue);
   }
   
+  // Add to filter array
+  tempReadings[tempReadingIndex] = rawValue;
+  tempReadingIndex = (tempReadingIndex + 1) % TEMP_FILTER_SIZE;
+  
   // Calculate average of filtered readings
   long sum = 0;
   for (int i = 0; i < TEMP_FILTER_SIZE; i++) {
@@ -75,6 +89,14 @@ int readTemperatureSensor() {
   return mapTemperature(averageValue);
 }
 
+/**
+ * Get the raw ADC value of the latest filtered reading
+ * @return Raw ADC value (0-1023), without triggering a conversion
+ */
+int getLastTemperatureSensorRaw() {
+  return tempLastRawValue;
+}
+
 /**
  * Map ADC value to temperature in Celsius (for thermistor)
  * @param adcValue Raw ADC value (0-1023)
@@ -120,6 +142,7 @@ float readTemperatureSensorVoltage() {
   return (adcValue * 5.0) / 1023.0;
 }
 
+#if ECU_FEATURE_FAHRENHEIT
 /**
  * Read temperature in Fahrenheit
  * @return Temperature in Fahrenheit
@@ -128,22 +151,17 @@ int readTemperatureSensorFahrenheit() {
   int celsius = readTemperatureSensor();
   return (celsius * 9.0 / 5.0) + 32;
 }
+#endif
 
 /**
- * Get temperature sensor status
- * @return true if sensor is working properly, false if there's an issue
+ * Get temperature sensor status from the diagnostics stage
+ * @return true if sensor is working properly, false if a fault is active
  */
 bool getTemperatureSensorStatus() {
-  float voltage = readTemperatureSensorVoltage();
-  
-  // Check if voltage is within expected range
-  if (voltage < 0.1 || voltage > 4.9) {
-    return false; // Sensor disconnected or faulty
-  }
-  
-  return true;
+  return !isSensorFaultActive(DIAG_CHANNEL_COOLANT);
 }
 
+#if ECU_FEATURE_DESCRIPTIONS
 /**
  * Get temperature description
  * @param temperature Temperature in Celsius
@@ -166,6 +184,7 @@ String getTemperatureDescription(int temperature) {
     return "CRITICAL";
   }
 }
+#endif
 
 /**
  * Check if temperature is in normal operating range
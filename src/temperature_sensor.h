@@ -2,6 +2,7 @@
 #define TEMPERATURE_SENSOR_H
 
 #include <Arduino.h>
+#include "build_profile.h"
 
 // Temperature sensor configuration constants
 extern const int TEMP_SENSOR_PIN;
@@ -23,11 +24,16 @@ extern const int TEMP_FILTER_SIZE;
 void initializeTemperatureSensor();
 int readTemperatureSensorRaw();
 int readTemperatureSensor();
+int getLastTemperatureSensorRaw();
 int mapTemperature(int adcValue);
 float readTemperatureSensorVoltage();
+#if ECU_FEATURE_FAHRENHEIT
 int readTemperatureSensorFahrenheit();
+#endif
 bool getTemperatureSensorStatus();
+#if ECU_FEATURE_DESCRIPTIONS
 String getTemperatureDescription(int temperature);
+#endif
 bool isTemperatureNormal(int temperature);
 bool isTemperatureCritical(int temperature);
 
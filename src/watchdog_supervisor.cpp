@@ -0,0 +1,254 @@
+#include "watchdog_supervisor.h"
+#include "glow_plug.h"
+#include <avr/wdt.h>
+#include <util/atomic.h>
+
+// Hardware watchdog runs in interrupt + reset mode: the first timeout fires
+// WDT_vect (outputs forced safe, starved task recorded), the second resets.
+const uint8_t WATCHDOG_TIMEOUT = WDTO_500MS;
+
+const uint8_t RESET_TASK_NONE = 0xFF;
+
+// Per-task run time deadlines in milliseconds (must stay below the watchdog timeout).
+// Each task is timed from its own taskBegin() to the next taskBegin() or
+// serviceWatchdog(), so a slow task is never blamed on the tasks before it.
+static const unsigned long taskDeadlinesMs[TASK_COUNT] = {
+  200, // TASK_GLOW_PLUG
+  200, // TASK_OIL_PRESSURE
+  400, // TASK_SENSORS (a fuel reading is spread over passes, ~2ms each)
+#if ECU_FEATURE_LCD
+  400  // TASK_LCD (I2C bus can hang inside Wire)
+#endif
+};
+
+// Task currently running and when it started, read by the watchdog interrupt
+static volatile uint8_t currentTask = RESET_TASK_NONE;
+static volatile unsigned long currentTaskStart = 0;
+static bool supervisorRunning = false;
+
+// Worst deadline miss of a task that returned during this loop
+static uint8_t lateTask = RESET_TASK_NONE;
+static unsigned long lateTaskOverdueMs = 0;
+
+// Loop time, measured between consecutive serviceWatchdog() calls
+static unsigned long lastServiceMicros = 0;
+static unsigned long loopTimePeakMicros = 0;
+
+// Record kept across the watchdog reset in uninitialised RAM
+const uint16_t RESET_RECORD_MAGIC = 0xD09E;
+
+struct ResetRecord {
+  uint16_t magic;
+  uint8_t starvedTask;
+  uint8_t resetCount;       // Consecutive watchdog resets
+  unsigned long overdueMs;  // How far past its deadline the task was
+};
+
+static ResetRecord resetRecord __attribute__((section(".noinit")));
+static volatile bool starvationRecorded = false; // One record per reset
+static uint8_t resetFlags __attribute__((section(".noinit")));
+
+// Optiboot reads and clears MCUSR before it starts the application and
+// passes the flags on in r2. Save r2 first thing after reset, in .init0,
+// before the C runtime start-up code uses any register.
+void saveBootloaderResetFlags() __attribute__((naked, used, section(".init0")));
+void saveBootloaderResetFlags() {
+  __asm__ __volatile__("sts %0, r2\n" : "=m"(resetFlags));
+}
+
+// Runs before main(): fall back to MCUSR when the bootloader passed no flags
+// (a board programmed over ISP without a bootloader), clear it, and stop a
+// watchdog left running by the reset, otherwise it would fire again during setup().
+void captureResetFlags() __attribute__((naked, used, section(".init3")));
+void captureResetFlags() {
+  if (resetFlags == 0) {
+    resetFlags = MCUSR;
+  }
+  MCUSR = 0;
+  wdt_disable();
+}
+
+/**
+ * How far a task that started at start is past its deadline
+ * @return Milliseconds overdue, 0 if still within the deadline
+ */
+static unsigned long getOverdueMs(uint8_t task, unsigned long start, unsigned long now) {
+  unsigned long runMs = now - start;
+  return runMs > taskDeadlinesMs[task] ? runMs - taskDeadlinesMs[task] : 0;
+}
+
+/**
+ * Stop timing the current task and remember it if it ran past its deadline
+ */
+static void endCurrentTask(unsigned long now) {
+  uint8_t task = currentTask;
+  if (task == RESET_TASK_NONE) {
+    return;
+  }
+
+  unsigned long overdueMs = getOverdueMs(task, currentTaskStart, now);
+  if (overdueMs > 0 && (lateTask == RESET_TASK_NONE || overdueMs > lateTaskOverdueMs)) {
+    lateTask = task;
+    lateTaskOverdueMs = overdueMs;
+  }
+  currentTask = RESET_TASK_NONE;
+}
+
+/**
+ * Put outputs in a safe state and remember which task starved
+ * Safe to call from the watchdog interrupt. Only the first call before a reset
+ * is recorded, later ones would count the same reset twice.
+ */
+static void handleStarvation(uint8_t task, unsigned long overdueMs) {
+  forceGlowPlugOff();
+
+  if (starvationRecorded) {
+    return;
+  }
+  starvationRecorded = true;
+
+  if (resetRecord.magic != RESET_RECORD_MAGIC) {
+    resetRecord.resetCount = 0;
+  }
+  resetRecord.magic = RESET_RECORD_MAGIC;
+  resetRecord.starvedTask = task;
+  resetRecord.overdueMs = overdueMs;
+  if (resetRecord.resetCount < 255) {
+    resetRecord.resetCount++;
+  }
+}
+
+static const __FlashStringHelper* getTaskName(uint8_t task) {
+  switch (task) {
+    case TASK_GLOW_PLUG: return F("GLOW");
+    case TASK_OIL_PRESSURE: return F("OIL");
+    case TASK_SENSORS: return F("SENSORS");
+#if ECU_FEATURE_LCD
+    case TASK_LCD: return F("LCD");
+#endif
+    default: return F("NONE");
+  }
+}
+
+/**
+ * Report why the ECU last reset over serial
+ * Call once after Serial.begin(), before setupWatchdogSupervisor().
+ */
+void reportResetCause() {
+  bool watchdogRecord = resetRecord.magic == RESET_RECORD_MAGIC;
+
+  // After an external reset Optiboot runs and leaves through its own watchdog
+  // reset, so EXTRF with WDRF is an external reset, not a watchdog one
+  const __FlashStringHelper* cause;
+  if (watchdogRecord) {
+    cause = F("WATCHDOG");
+  } else if (resetFlags & _BV(EXTRF)) {
+    cause = F("EXTERNAL");
+  } else if (resetFlags & _BV(WDRF)) {
+    cause = F("WATCHDOG");
+  } else if (resetFlags & _BV(BORF)) {
+    cause = F("BROWN_OUT");
+  } else if (resetFlags & _BV(PORF)) {
+    cause = F("POWER_ON");
+  } else {
+    cause = F("UNKNOWN");
+  }
+
+  if (FEATURE_TELEMETRY) {
+    Serial.print(F("RESET:"));
+    Serial.println(cause);
+    if (watchdogRecord) {
+      Serial.print(F("WDT_STARVED:"));
+      Serial.println(getTaskName(resetRecord.starvedTask));
+    }
+  }
+
+  if (FEATURE_DEBUG_LOG && watchdogRecord) {
+    Serial.print(F("Watchdog reset #"));
+    Serial.print(resetRecord.resetCount);
+    Serial.print(F(": task overdue by "));
+    Serial.print(resetRecord.overdueMs);
+    Serial.println(F("ms"));
+  }
+
+  if (watchdogRecord) {
+    // Keep the count for back-to-back resets, but only report each one once
+    resetRecord.magic = 0;
+  } else {
+    resetRecord.resetCount = 0;
+  }
+}
+
+/**
+ * Start the hardware watchdog
+ * Call at the end of setup() so startup delays are not supervised.
+ */
+void setupWatchdogSupervisor() {
+  wdt_enable(WATCHDOG_TIMEOUT);
+  WDTCSR |= _BV(WDIE); // Interrupt before reset
+  supervisorRunning = true;
+  lastServiceMicros = micros();
+}
+
+/**
+ * Record that a task is about to run
+ * Ends the previous task, whose run time is checked against its deadline.
+ */
+void taskBegin(SupervisedTask task) {
+  unsigned long now = millis();
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    endCurrentTask(now);
+    currentTaskStart = now; // Both read by the watchdog interrupt
+    currentTask = task;
+  }
+}
+
+/**
+ * Check every task against its deadline and pet the watchdog
+ * Call once at the end of every loop().
+ */
+void serviceWatchdog() {
+  if (!supervisorRunning) {
+    return;
+  }
+
+  unsigned long nowMicros = micros();
+  unsigned long loopMicros = nowMicros - lastServiceMicros;
+  lastServiceMicros = nowMicros;
+  if (loopMicros > loopTimePeakMicros) {
+    loopTimePeakMicros = loopMicros;
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    endCurrentTask(millis());
+  }
+
+  if (lateTask != RESET_TASK_NONE) {
+    // A task returned but missed its deadline: stop petting and let the watchdog reset.
+    // Reset-only mode from here, the interrupt has nothing left to record.
+    handleStarvation(lateTask, lateTaskOverdueMs);
+    WDTCSR &= ~_BV(WDIE);
+    while (true) {
+    }
+  }
+
+  wdt_reset();
+}
+
+/**
+ * Read and reset the longest loop time since the last call
+ * @return Peak loop time in tenths of a millisecond
+ */
+int readLoopTimePeak() {
+  unsigned long peak = loopTimePeakMicros;
+  loopTimePeakMicros = 0;
+  return peak >= 3276700UL ? 32767 : peak / 100;
+}
+
+// First watchdog timeout: loop() is stuck (e.g. I2C hang), the next timeout resets.
+// The task that is still running is the one that hung.
+ISR(WDT_vect) {
+  uint8_t task = currentTask;
+  unsigned long overdueMs = task == RESET_TASK_NONE ? 0 : getOverdueMs(task, currentTaskStart, millis());
+  handleStarvation(task, overdueMs);
+}
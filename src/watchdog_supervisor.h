@@ -0,0 +1,28 @@
+#ifndef WATCHDOG_SUPERVISOR_H
+#define WATCHDOG_SUPERVISOR_H
+
+#include <Arduino.h>
+#include "build_profile.h"
+
+// Subsystems timed by the supervisor, each started with taskBegin()
+enum SupervisedTask {
+  TASK_GLOW_PLUG,
+  TASK_OIL_PRESSURE,
+  TASK_SENSORS,
+#if ECU_FEATURE_LCD
+  TASK_LCD,
+#endif
+  TASK_COUNT
+};
+
+// Hardware watchdog timeout (WDTO_* constant)
+extern const uint8_t WATCHDOG_TIMEOUT;
+
+// Watchdog supervisor functions
+void reportResetCause();
+void setupWatchdogSupervisor();
+void taskBegin(SupervisedTask task);
+void serviceWatchdog();
+int readLoopTimePeak();
+
+#endif
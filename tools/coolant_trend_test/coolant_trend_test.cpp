@@ -0,0 +1,208 @@
+// Drives the coolant trend estimator with simulated engine runs, sampled the
+// way the channel registry does, and checks the warning lead and false-alarm
+// margins quoted in coolant_trend.cpp. Engine runs go through the real sensor
+// path: thermistor voltage, 10-bit ADC, the 5-sample filter and mapTemperature().
+
+#include <cmath>
+#include <cstdio>
+
+#include "channel_registry.h"
+#include "coolant_trend.h"
+#include "sensor_diagnostics.h"
+#include "temperature_sensor.h"
+
+// Channel registry stand-ins: the estimator only reads the coolant channel
+static int coolantTemperature = 20;
+static bool coolantValid = true;
+
+bool isChannelValid(ChannelId) { return coolantValid; }
+int getChannelValue(ChannelId) { return coolantTemperature; }
+bool isChannelInAlarm(ChannelId) { return false; }
+
+// Diagnostics and Arduino stand-ins for temperature_sensor.cpp
+bool isSensorSampleInRange(DiagnosticChannel, int rawValue) { return rawValue > 2 && rawValue < 1010; }
+bool isSensorFaultActive(DiagnosticChannel) { return false; }
+
+static int adcReading = 0;
+int analogRead(uint8_t) { return adcReading; }
+void pinMode(uint8_t, uint8_t) {}
+void delay(unsigned long) {}
+
+static const int WARNING_ETA_S = 120;     // TEMP_ETA alarm threshold in the channel table
+static const double THERMOSTAT_TEMP = 88; // Warm engine plateau
+static const double PLATEAU_S = 600;      // Time held at the thermostat before a failure
+static const double STEP_S = 0.5;         // Simulation step
+static const double COOLANT_PERIOD_S = 1.0; // CHANNEL_COOLANT sample period
+
+static int failures = 0;
+
+static void check(bool condition, const char* description) {
+  std::printf("%s: %s\n", condition ? "PASS" : "FAIL", description);
+  if (!condition) {
+    failures++;
+  }
+}
+
+// ADC count for a coolant temperature, the inverse of mapTemperature()
+static int temperatureToAdc(double celsius) {
+  double kelvin = celsius + 273.15;
+  double nominalKelvin = TEMP_SENSOR_NOMINAL_TEMP + 273.15;
+  double resistance = TEMP_SENSOR_NOMINAL_RESISTANCE *
+                      std::exp(TEMP_SENSOR_BETA_COEFFICIENT * (1.0 / kelvin - 1.0 / nominalKelvin));
+  return (int)std::lround(1023.0 * resistance / (TEMP_SENSOR_PULLUP_RESISTOR + resistance));
+}
+
+struct RunResult {
+  int minimumEtaBeforeFailure; // Lowest projection while warming up and at the thermostat
+  double warningLeadS;         // Warning to first critical reading, negative if no warning
+  int plateauRateX10;          // Last rate reported at the thermostat
+};
+
+// Warm up from 20°C at warmupRate (°C/min), hold at the thermostat with the
+// coolant wandering by +-0.5°C, then climb at failureRate until the coolant
+// reading is critical. failureRate 0 ends the run after the plateau.
+static RunResult simulateRun(double warmupRate, double failureRate) {
+  initializeTemperatureSensor();
+  initializeCoolantTrend();
+  coolantValid = true;
+
+  const double warmupS = (THERMOSTAT_TEMP - 20) / warmupRate * 60;
+  const double failureS = warmupS + PLATEAU_S;
+  const double endS = failureRate > 0 ? failureS + 3600 : failureS;
+  const double trendPeriodS = COOLANT_TREND_SAMPLE_MS / 1000.0;
+
+  RunResult result = { COOLANT_TREND_ETA_MAX_S, -1, 0 };
+  double warningAt = -1;
+  double nextCoolant = 0;
+  double nextTrend = 0;
+
+  for (double seconds = 0; seconds < endS; seconds += STEP_S) {
+    double temperature;
+    if (seconds < warmupS) {
+      temperature = 20 + warmupRate * seconds / 60;
+    } else if (seconds < failureS) {
+      temperature = THERMOSTAT_TEMP + 0.5 * std::sin((seconds - warmupS) / 40);
+    } else {
+      temperature = THERMOSTAT_TEMP + failureRate * (seconds - failureS) / 60;
+    }
+    adcReading = temperatureToAdc(temperature);
+
+    if (seconds >= nextCoolant) {
+      nextCoolant += COOLANT_PERIOD_S;
+      coolantTemperature = readTemperatureSensor();
+    }
+    if (seconds < nextTrend) {
+      continue;
+    }
+    nextTrend += trendPeriodS;
+
+    int rate = readCoolantTemperatureRate();
+    int eta = readCoolantTimeToCritical();
+
+    if (seconds < failureS) {
+      result.minimumEtaBeforeFailure = std::min(result.minimumEtaBeforeFailure, eta);
+      result.plateauRateX10 = rate;
+    } else if (eta <= WARNING_ETA_S && warningAt < 0) {
+      warningAt = seconds;
+    }
+
+    if (coolantTemperature >= COOLANT_TREND_CRITICAL_TEMP) {
+      if (warningAt >= 0) {
+        result.warningLeadS = seconds - warningAt;
+      }
+      break;
+    }
+  }
+  return result;
+}
+
+// A steady ramp is reported as its rate once the window is full
+static void testSteadyRamp() {
+  initializeCoolantTrend();
+  coolantValid = true;
+
+  // 1°C every sample is exactly representable: 24 samples a minute
+  int rate = 0;
+  for (int sample = 0; sample < COOLANT_TREND_WINDOW * 2; sample++) {
+    coolantTemperature = 20 + sample;
+    rate = readCoolantTemperatureRate();
+  }
+  check(rate == 240, "1°C per sample ramp reported as 24.0°C/min");
+
+  // 3°C/min arrives in 1°C steps every 8 samples; the fit depends on where
+  // the steps fall in the window, so check every phase
+  initializeCoolantTrend();
+  int lowest = 1000;
+  int highest = -1000;
+  for (int sample = 0; sample < COOLANT_TREND_WINDOW * 3; sample++) {
+    coolantTemperature = 40 + sample / 8;
+    rate = readCoolantTemperatureRate();
+    if (sample >= COOLANT_TREND_WINDOW) {
+      lowest = std::min(lowest, rate);
+      highest = std::max(highest, rate);
+    }
+  }
+  std::printf("3°C/min in 1°C steps: rate %d..%d\n", lowest, highest);
+  check(lowest >= 27 && highest <= 33, "3°C/min in 1°C steps reported within 0.3°C/min");
+}
+
+// No slope is reported until the window holds enough history
+static void testMinimumSamples() {
+  initializeCoolantTrend();
+  coolantValid = true;
+
+  bool quiet = true;
+  for (int sample = 0; sample < COOLANT_TREND_MIN_SAMPLES - 1; sample++) {
+    coolantTemperature = 60 + sample;
+    quiet = quiet && readCoolantTemperatureRate() == 0 &&
+            readCoolantTimeToCritical() == COOLANT_TREND_ETA_MAX_S;
+  }
+  check(quiet, "no rate or projection before COOLANT_TREND_MIN_SAMPLES");
+}
+
+// A sensor fault empties the window instead of feeding it garbage
+static void testInvalidSensorResets() {
+  initializeCoolantTrend();
+  coolantValid = true;
+  for (int sample = 0; sample < COOLANT_TREND_WINDOW; sample++) {
+    coolantTemperature = 60 + sample;
+    readCoolantTemperatureRate();
+  }
+
+  coolantValid = false;
+  coolantTemperature = 150;
+  int rate = readCoolantTemperatureRate();
+  check(rate == 0 && readCoolantTimeToCritical() == COOLANT_TREND_ETA_MAX_S,
+        "invalid coolant channel resets the trend");
+}
+
+int main() {
+  testSteadyRamp();
+  testMinimumSamples();
+  testInvalidSensorResets();
+
+  // Water pump failure: 5°C/min from the thermostat, the case the window was sized for
+  RunResult pumpFailure = simulateRun(3, 5);
+  std::printf("5°C/min failure: warning %.0fs before critical\n", pumpFailure.warningLeadS);
+  check(pumpFailure.warningLeadS >= 90, "5°C/min failure warned at least 90s before critical");
+  check(std::abs(pumpFailure.plateauRateX10) <= COOLANT_TREND_MIN_RATE_X10,
+        "thermostat plateau reads as flat");
+
+  // A faster failure still gets a warning ahead of the coolant alarm
+  RunResult fastFailure = simulateRun(3, 10);
+  std::printf("10°C/min failure: warning %.0fs before critical\n", fastFailure.warningLeadS);
+  check(fastFailure.warningLeadS > 0, "10°C/min failure warned before critical");
+
+  // Healthy warm-ups into the thermostat, slow to very fast, must never warn
+  const double warmupRates[] = { 2, 3, 6, 8, 12, 20 };
+  for (double warmupRate : warmupRates) {
+    RunResult warmup = simulateRun(warmupRate, 0);
+    char description[64];
+    std::snprintf(description, sizeof(description), "%.0f°C/min warm-up never projects %ds or less",
+                  warmupRate, WARNING_ETA_S);
+    std::printf("%.0f°C/min warm-up: lowest projection %ds\n", warmupRate, warmup.minimumEtaBeforeFailure);
+    check(warmup.minimumEtaBeforeFailure > WARNING_ETA_S, description);
+  }
+
+  return failures == 0 ? 0 : 1;
+}
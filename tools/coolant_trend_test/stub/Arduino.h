@@ -0,0 +1,23 @@
+#ifndef ARDUINO_STUB_H
+#define ARDUINO_STUB_H
+
+// Just enough of the Arduino core to build coolant_trend.cpp and
+// temperature_sensor.cpp on the host
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+typedef const char* PGM_P;
+
+#define INPUT 0
+#define A0 14
+
+int analogRead(uint8_t pin);
+void pinMode(uint8_t pin, uint8_t mode);
+void delay(unsigned long ms);
+
+using std::max;
+using std::min;
+
+#endif
@@ -0,0 +1,14 @@
+#!/bin/sh
+# Builds every build profile and prints its flash and RAM use in one table.
+# Run from the repository root; needs PlatformIO (pio) on the PATH.
+set -e
+
+ENVIRONMENTS="diagnostic-full headless-telemetry lcd-only"
+
+printf '%-20s %-8s %-8s\n' "Environment" "Flash" "RAM"
+for env in $ENVIRONMENTS; do
+  output=$(pio run -e "$env" 2>&1) || { echo "$output"; exit 1; }
+  flash=$(echo "$output" | sed -n 's/^Flash:.*used \([0-9]*\) bytes.*/\1/p')
+  ram=$(echo "$output" | sed -n 's/^RAM:.*used \([0-9]*\) bytes.*/\1/p')
+  printf '%-20s %-8s %-8s\n' "$env" "$flash" "$ram"
+done
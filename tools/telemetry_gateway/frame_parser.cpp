@@ -0,0 +1,22 @@
+#include "frame_parser.h"
+
+FrameParser::FrameParser(std::size_t capacity) : buffer_(capacity) {}
+
+void FrameParser::compact(std::size_t consumed) {
+  if (consumed > 0) {
+    std::memmove(buffer_.data(), buffer_.data() + consumed, used_ - consumed);
+    used_ -= consumed;
+    scanned_ -= consumed;
+  }
+
+  // A line that fills the whole buffer can never complete: drop it and
+  // skip everything up to the next terminator
+  if (used_ == buffer_.size()) {
+    if (!discarding_) {
+      oversized_++;
+    }
+    discarding_ = true;
+    used_ = 0;
+    scanned_ = 0;
+  }
+}
@@ -0,0 +1,70 @@
+#ifndef FRAME_PARSER_H
+#define FRAME_PARSER_H
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// Incremental newline framing over a fixed receive buffer.
+// Bytes are read straight into writable() and lines are handed out as views
+// into the same buffer, so complete lines are never copied. Only the trailing
+// partial line is moved to the front after each pass.
+class FrameParser {
+ public:
+  explicit FrameParser(std::size_t capacity = 4096);
+
+  char* writable() { return buffer_.data() + used_; }
+  std::size_t writableSize() const { return buffer_.size() - used_; }
+  void commit(std::size_t bytes) { used_ += bytes; }
+
+  // Calls onLine(std::string_view) for every complete line, without the
+  // line terminator. Returns the number of lines delivered.
+  template <typename Callback>
+  std::size_t parse(Callback&& onLine);
+
+  std::size_t oversizedLines() const { return oversized_; }
+
+ private:
+  void compact(std::size_t consumed);
+
+  std::vector<char> buffer_;
+  std::size_t used_ = 0;
+  std::size_t scanned_ = 0;   // Bytes already known not to contain '\n'
+  bool discarding_ = false;   // Skipping the rest of an oversized line
+  std::size_t oversized_ = 0;
+};
+
+template <typename Callback>
+std::size_t FrameParser::parse(Callback&& onLine) {
+  std::size_t lines = 0;
+  std::size_t start = 0;
+  const char* base = buffer_.data();
+
+  while (true) {
+    const void* found = std::memchr(base + scanned_, '\n', used_ - scanned_);
+    if (found == nullptr) {
+      break;
+    }
+
+    std::size_t end = static_cast<const char*>(found) - base;
+    if (discarding_) {
+      discarding_ = false;
+    } else {
+      std::size_t length = end - start;
+      if (length > 0 && base[end - 1] == '\r') {
+        length--;
+      }
+      onLine(std::string_view(base + start, length));
+      lines++;
+    }
+    start = end + 1;
+    scanned_ = start;
+  }
+
+  scanned_ = used_;
+  compact(start);
+  return lines;
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include "gateway.h"
+
+#include <cerrno>
+#include <ctime>
+#include <poll.h>
+#include <unistd.h>
+
+int64_t monotonicNowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+Gateway::Gateway(std::size_t ringCapacity, OutputFormat format, std::FILE* output, bool logEvents)
+    : ring_(ringCapacity), format_(format), output_(output), logEvents_(logEvents) {
+  if (format_ == OutputFormat::Csv) {
+    std::fputs("time_ns,channel,value\n", output_);
+  }
+}
+
+bool Gateway::readFrom(int fd) {
+  ssize_t received = read(fd, parser_.writable(), parser_.writableSize());
+  if (received < 0 && errno == EINTR) {
+    return true;
+  }
+  if (received <= 0) {
+    return false;
+  }
+
+  // Every line from one read() shares a timestamp
+  int64_t timeNs = monotonicNowNs();
+  parser_.commit(static_cast<std::size_t>(received));
+  counters_.bytes += static_cast<uint64_t>(received);
+  counters_.reads++;
+  counters_.lines += parser_.parse([&](std::string_view line) { handleLine(line, timeNs); });
+  return true;
+}
+
+void Gateway::sendAck(int32_t sequence) {
+  char ack[16];
+  std::size_t length = formatAck(ack, sizeof(ack), sequence);
+
+  // Never block the reader on a stalled link: an unacknowledged alarm is repeated
+  pollfd pfd{ackFd_, POLLOUT, 0};
+  if (length == 0 || poll(&pfd, 1, 0) <= 0 || write(ackFd_, ack, length) != static_cast<ssize_t>(length)) {
+    counters_.acksDropped++;
+    return;
+  }
+  counters_.acksSent++;
+}
+
+void Gateway::handleLine(std::string_view line, int64_t timeNs) {
+  Message message = decodeLine(line);
+
+  // Damaged alarms are not acknowledged, so the ECU sends them again
+  if (ackFd_ >= 0 && message.sequence > 0 &&
+      (message.kind == MessageKind::Sample || message.kind == MessageKind::Event)) {
+    sendAck(message.sequence);
+  }
+
+  switch (message.kind) {
+    case MessageKind::Sample:
+      counters_.samples++;
+      ring_.push({timeNs, message.channel, message.value});
+      stats_[message.channel].add(message.value);
+      if (format_ == OutputFormat::Csv) {
+        std::fprintf(output_, "%lld,%s,%d\n", static_cast<long long>(timeNs),
+                     channelName(message.channel), message.value);
+      } else if (format_ == OutputFormat::Binary) {
+        BinaryRecord record{timeNs, message.channel, 0, message.value};
+        std::fwrite(&record, sizeof(record), 1, output_);
+      }
+      break;
+    case MessageKind::Event:
+      counters_.events++;
+      if (logEvents_) {
+        std::fprintf(stderr, "event %.*s %.*s\n", static_cast<int>(message.key.size()), message.key.data(),
+                     static_cast<int>(message.payload.size()), message.payload.data());
+      }
+      break;
+    case MessageKind::Text:
+      counters_.text++;
+      break;
+    case MessageKind::Malformed:
+      counters_.malformed++;
+      break;
+  }
+}
+
+void Gateway::printStats(std::FILE* out, double elapsedSeconds, double windowSeconds) const {
+  double seconds = elapsedSeconds > 0 ? elapsedSeconds : 1.0;
+  std::fprintf(out, "%.1fs: %llu bytes (%.0f B/s), %llu lines (%.0f/s), %llu samples, %llu events, "
+               "%llu text, %llu malformed, %zu oversized, %llu acks (%llu dropped), ring %zu/%zu (%llu overwritten)\n",
+               elapsedSeconds, static_cast<unsigned long long>(counters_.bytes), counters_.bytes / seconds,
+               static_cast<unsigned long long>(counters_.lines), counters_.lines / seconds,
+               static_cast<unsigned long long>(counters_.samples), static_cast<unsigned long long>(counters_.events),
+               static_cast<unsigned long long>(counters_.text), static_cast<unsigned long long>(counters_.malformed),
+               parser_.oversizedLines(), static_cast<unsigned long long>(counters_.acksSent),
+               static_cast<unsigned long long>(counters_.acksDropped), ring_.size(), ring_.capacity(),
+               static_cast<unsigned long long>(ring_.overwritten()));
+
+  // Recent window from the time-indexed ring
+  int64_t now = monotonicNowNs();
+  int64_t windowStart = now - static_cast<int64_t>(windowSeconds * 1e9);
+  ChannelStats window[CHANNEL_COUNT];
+  ring_.forEachInRange(windowStart, now + 1, [&](const Sample& sample) { window[sample.channel].add(sample.value); });
+
+  for (uint16_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+    const ChannelStats& all = stats_[channel];
+    if (all.count == 0) {
+      continue;
+    }
+    std::fprintf(out, "  %-10s n=%-10llu min=%-6d max=%-6d mean=%-8.2f last=%-6d | last %.0fs: n=%llu mean=%.2f\n",
+                 channelName(channel), static_cast<unsigned long long>(all.count), all.min, all.max, all.mean(),
+                 all.last, windowSeconds, static_cast<unsigned long long>(window[channel].count),
+                 window[channel].mean());
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+#include "frame_parser.h"
+#include "sample_ring.h"
+#include "telemetry_protocol.h"
+
+enum class OutputFormat { None, Csv, Binary };
+
+struct GatewayCounters {
+  uint64_t bytes = 0;
+  uint64_t reads = 0;
+  uint64_t lines = 0;
+  uint64_t samples = 0;
+  uint64_t events = 0;
+  uint64_t text = 0;
+  uint64_t malformed = 0;
+  uint64_t acksSent = 0;
+  uint64_t acksDropped = 0;   // Link not writable; the ECU will repeat the alarm
+};
+
+// Packed little-endian record written in binary output mode
+struct BinaryRecord {
+  int64_t timeNs;
+  uint16_t channel;
+  uint16_t reserved;
+  int32_t value;
+};
+static_assert(sizeof(BinaryRecord) == 16, "binary record layout");
+
+// Reads the ECU stream, frames it, decodes it and keeps the samples
+class Gateway {
+ public:
+  Gateway(std::size_t ringCapacity, OutputFormat format, std::FILE* output, bool logEvents);
+
+  // One read() from fd. Returns false on end of stream or error.
+  bool readFrom(int fd);
+
+  // Answer sequenced alarm messages with "ACK:<n>" on fd (-1 = never)
+  void acknowledgeTo(int fd) { ackFd_ = fd; }
+
+  void printStats(std::FILE* out, double elapsedSeconds, double windowSeconds) const;
+
+  const GatewayCounters& counters() const { return counters_; }
+  const SampleRing& ring() const { return ring_; }
+  std::size_t oversizedLines() const { return parser_.oversizedLines(); }
+
+ private:
+  void handleLine(std::string_view line, int64_t timeNs);
+  void sendAck(int32_t sequence);
+
+  FrameParser parser_;
+  SampleRing ring_;
+  ChannelStats stats_[CHANNEL_COUNT];
+  GatewayCounters counters_;
+  OutputFormat format_;
+  std::FILE* output_;
+  bool logEvents_;
+  int ackFd_ = -1;
+};
+
+int64_t monotonicNowNs();
+
+#endif
@@ -0,0 +1,139 @@
+#include "load_generator.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t BATCH_BYTES = 256;
+
+}  // namespace
+
+LoadGenerator::LoadGenerator(int fd, double bytesPerSecond)
+    : fd_(fd), bytesPerSecond_(bytesPerSecond) {
+  int flags = fcntl(fd_, F_GETFL);
+  if (flags >= 0) {
+    fcntl(fd_, F_SETFL, flags | O_NONBLOCK);
+  }
+}
+
+uint32_t LoadGenerator::nextRandom() {
+  // xorshift32: deterministic, so runs are comparable
+  rng_ ^= rng_ << 13;
+  rng_ ^= rng_ >> 17;
+  rng_ ^= rng_ << 5;
+  return rng_;
+}
+
+int LoadGenerator::nextAlarmSequence() {
+  // Same 1..255 range as the ECU
+  alarmSequence_ = alarmSequence_ == 255 ? 1 : alarmSequence_ + 1;
+  stats_.alarmsOffered++;
+  return alarmSequence_;
+}
+
+// Count acknowledgements sent back by the gateway (the only traffic towards the ECU)
+void LoadGenerator::readAcks() {
+  char buffer[256];
+  ssize_t received;
+  while ((received = read(fd_, buffer, sizeof(buffer))) > 0) {
+    for (ssize_t i = 0; i < received; i++) {
+      stats_.acksReceived += buffer[i] == '\n';
+    }
+  }
+}
+
+std::size_t LoadGenerator::formatLine(char* out, std::size_t capacity) {
+  uint64_t n = sequence_++;
+  int length;
+
+  if (n % 1000 == 999) {
+    length = std::snprintf(out, capacity, "%s:P0118#%d\n", (n / 1000) % 2 ? "DTC_CLR" : "DTC_SET",
+                           nextAlarmSequence());
+  } else if (n % 200 == 150) {
+    length = std::snprintf(out, capacity, "Glow plug activated! GLOW_TIME_SECONDS = 10\n");
+  } else if (n % 50 == 25) {
+    oilWarn_ = !oilWarn_;
+    length = std::snprintf(out, capacity, "OIL_WARN:%d#%d\n", oilWarn_ ? 1 : 0, nextAlarmSequence());
+  } else if (n % 75 == 40) {
+    glow_ = !glow_;
+    length = std::snprintf(out, capacity, "GLOW:%d\n", glow_ ? 1 : 0);
+  } else if (n % 100 == 60) {
+    length = std::snprintf(out, capacity, "BATT:%d\n", 138 + static_cast<int>(nextRandom() % 5) - 2);
+  } else if (n % 2 == 0) {
+    // Warm-up ramp with a little noise, then hover around the thermostat
+    int step = static_cast<int>(nextRandom() % 3) - 1;
+    if (coolant_ < 86) {
+      step += 1;
+    } else if (coolant_ > 90) {
+      step -= 1;
+    }
+    coolant_ += step;
+    length = std::snprintf(out, capacity, "COOLANT:%d\n", coolant_);
+  } else {
+    fuel_ += static_cast<int>(nextRandom() % 3) - 1;
+    fuel_ = fuel_ < 0 ? 0 : (fuel_ > 100 ? 100 : fuel_);
+    length = std::snprintf(out, capacity, "FUEL:%d\n", fuel_);
+  }
+
+  return length > 0 ? static_cast<std::size_t>(length) : 0;
+}
+
+void LoadGenerator::run(double seconds, const std::atomic<bool>& stop) {
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  const auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+  char batch[BATCH_BYTES];
+  std::size_t lineEnds[BATCH_BYTES];
+
+  while (!stop.load(std::memory_order_relaxed) && Clock::now() < deadline) {
+    // Fill a batch with whole lines
+    std::size_t length = 0;
+    std::size_t lines = 0;
+    while (true) {
+      if (pendingLength_ == 0) {
+        pendingLength_ = formatLine(pending_, sizeof(pending_));
+      }
+      if (length + pendingLength_ > sizeof(batch)) {
+        break;  // Goes first in the next batch
+      }
+      std::memcpy(batch + length, pending_, pendingLength_);
+      length += pendingLength_;
+      lineEnds[lines++] = length;
+      pendingLength_ = 0;
+    }
+
+    // Pace to the requested link rate
+    if (bytesPerSecond_ > 0) {
+      double due = (stats_.bytesOffered + length) / bytesPerSecond_;
+      auto dueTime = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(due));
+      if (dueTime > Clock::now()) {
+        std::this_thread::sleep_until(dueTime);
+      }
+    }
+
+    ssize_t written = write(fd_, batch, length);
+    if (written < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        std::perror("loadgen: write");
+        return;
+      }
+      written = 0;
+    }
+
+    readAcks();
+    stats_.bytesOffered += length;
+    stats_.bytesWritten += written;
+    stats_.bytesDropped += length - written;
+    stats_.linesOffered += lines;
+    for (std::size_t i = 0; i < lines && lineEnds[i] <= static_cast<std::size_t>(written); i++) {
+      stats_.linesIntact++;
+    }
+  }
+}
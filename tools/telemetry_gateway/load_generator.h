@@ -0,0 +1,54 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct LoadStats {
+  uint64_t bytesOffered = 0;
+  uint64_t bytesWritten = 0;
+  uint64_t bytesDropped = 0;
+  uint64_t linesOffered = 0;
+  uint64_t linesIntact = 0;   // Lines that reached the link complete
+  uint64_t alarmsOffered = 0; // Sequenced alarm lines ("OIL_WARN:1#17")
+  uint64_t acksReceived = 0;  // "ACK:<n>" lines read back from the link
+};
+
+// Emits synthetic ECU traffic (the same "KEY:value" lines communication.cpp
+// sends, plus debug text and trouble codes) into a file descriptor.
+// Writes are non-blocking: when the receiver falls behind, bytes that do not
+// fit are dropped, as a UART without flow control would.
+class LoadGenerator {
+ public:
+  // bytesPerSecond <= 0 writes as fast as the descriptor accepts
+  LoadGenerator(int fd, double bytesPerSecond);
+
+  void run(double seconds, const std::atomic<bool>& stop);
+  const LoadStats& stats() const { return stats_; }
+
+ private:
+  std::size_t formatLine(char* out, std::size_t capacity);
+  uint32_t nextRandom();
+  int nextAlarmSequence();
+  void readAcks();
+
+  int fd_;
+  double bytesPerSecond_;
+  LoadStats stats_;
+
+  // Simulated ECU state
+  uint32_t rng_ = 0x12345678;
+  uint64_t sequence_ = 0;
+  int alarmSequence_ = 0;
+  int coolant_ = 20;
+  int fuel_ = 60;
+  bool oilWarn_ = true;
+  bool glow_ = false;
+
+  // Line generated but not yet placed in a batch
+  char pending_[64];
+  std::size_t pendingLength_ = 0;
+};
+
+#endif
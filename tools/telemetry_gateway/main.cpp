@@ -0,0 +1,253 @@
+// Host-side gateway for the ECU serial telemetry stream.
+//
+//   ecu_gateway listen <tty> [--baud N] [--format csv|binary] [--output FILE]
+//                            [--ring N] [--stats SECONDS] [--window SECONDS]
+//   ecu_gateway loadgen [--baud N] [--rate X] [--seconds S]
+//   ecu_gateway bench   [--baud N] [--rate X] [--seconds S] [--ring N]
+//
+// --rate is a multiple of the link rate (baud / 10 bytes/s); 0 is unthrottled.
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "gateway.h"
+#include "load_generator.h"
+#include "serial_link.h"
+
+namespace {
+
+std::atomic<bool> stopRequested{false};
+
+void onSignal(int) { stopRequested = true; }
+
+struct Options {
+  std::string mode;
+  std::string device;
+  std::string output = "-";
+  OutputFormat format = OutputFormat::None;
+  int baud = ECU_BAUD_RATE;
+  double rate = 1.0;
+  double seconds = 10.0;
+  double statsInterval = 5.0;
+  double window = 10.0;
+  std::size_t ringCapacity = 1 << 20;
+};
+
+void printUsage() {
+  std::fputs(
+      "usage: ecu_gateway listen <tty> [--baud N] [--format csv|binary] [--output FILE]\n"
+      "                               [--ring N] [--stats SECONDS] [--window SECONDS]\n"
+      "       ecu_gateway loadgen [--baud N] [--rate X] [--seconds S]\n"
+      "       ecu_gateway bench   [--baud N] [--rate X] [--seconds S] [--ring N]\n",
+      stderr);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+  if (argc < 2) {
+    return false;
+  }
+  options.mode = argv[1];
+  int i = 2;
+  if (options.mode == "listen") {
+    if (argc < 3) {
+      return false;
+    }
+    options.device = argv[i++];
+  } else if (options.mode != "loadgen" && options.mode != "bench") {
+    return false;
+  }
+
+  for (; i < argc; i++) {
+    std::string flag = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char* value = argv[++i];
+    if (flag == "--baud") {
+      options.baud = std::atoi(value);
+    } else if (flag == "--rate") {
+      options.rate = std::atof(value);
+    } else if (flag == "--seconds") {
+      options.seconds = std::atof(value);
+    } else if (flag == "--stats") {
+      options.statsInterval = std::atof(value);
+    } else if (flag == "--window") {
+      options.window = std::atof(value);
+    } else if (flag == "--ring") {
+      options.ringCapacity = std::strtoul(value, nullptr, 10);
+    } else if (flag == "--output") {
+      options.output = value;
+    } else if (flag == "--format") {
+      if (std::strcmp(value, "csv") == 0) {
+        options.format = OutputFormat::Csv;
+      } else if (std::strcmp(value, "binary") == 0) {
+        options.format = OutputFormat::Binary;
+      } else {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+  return options.ringCapacity > 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::FILE* openOutput(const Options& options) {
+  if (options.format == OutputFormat::None) {
+    return nullptr;
+  }
+  if (options.output == "-") {
+    return stdout;
+  }
+  return std::fopen(options.output.c_str(), options.format == OutputFormat::Binary ? "wb" : "w");
+}
+
+int runListen(const Options& options) {
+  int fd = openSerialPort(options.device, options.baud);
+  if (fd < 0) {
+    std::fprintf(stderr, "ecu_gateway: %s: %s\n", options.device.c_str(), std::strerror(errno));
+    return 1;
+  }
+
+  std::FILE* output = openOutput(options);
+  if (options.format != OutputFormat::None && output == nullptr) {
+    std::fprintf(stderr, "ecu_gateway: %s: %s\n", options.output.c_str(), std::strerror(errno));
+    close(fd);
+    return 1;
+  }
+
+  Gateway gateway(options.ringCapacity, options.format, output, true);
+  gateway.acknowledgeTo(fd);
+  auto start = std::chrono::steady_clock::now();
+  double nextStats = options.statsInterval;
+
+  pollfd pfd{fd, POLLIN, 0};
+  while (!stopRequested) {
+    int ready = poll(&pfd, 1, 200);
+    if (ready > 0 && !gateway.readFrom(fd)) {
+      break;
+    }
+    if (options.statsInterval > 0 && secondsSince(start) >= nextStats) {
+      gateway.printStats(stderr, secondsSince(start), options.window);
+      nextStats += options.statsInterval;
+    }
+  }
+
+  gateway.printStats(stderr, secondsSince(start), options.window);
+  if (output != nullptr && output != stdout) {
+    std::fclose(output);
+  }
+  close(fd);
+  return 0;
+}
+
+int runLoadgen(const Options& options) {
+  PseudoTerminal pty;
+  if (!openPseudoTerminal(pty)) {
+    std::fprintf(stderr, "ecu_gateway: pty: %s\n", std::strerror(errno));
+    return 1;
+  }
+
+  double bytesPerSecond = bytesPerSecondForBaud(options.baud) * options.rate;
+  std::fprintf(stderr, "loadgen: writing to %s at %s for %.1fs\n", pty.slavePath.c_str(),
+               options.rate > 0 ? (std::to_string(static_cast<long>(bytesPerSecond)) + " B/s").c_str()
+                                : "full speed",
+               options.seconds);
+
+  LoadGenerator generator(pty.masterFd, bytesPerSecond);
+  generator.run(options.seconds, stopRequested);
+
+  const LoadStats& stats = generator.stats();
+  std::fprintf(stderr, "loadgen: %llu lines offered, %llu intact, %llu bytes written, %llu dropped, %llu/%llu alarms acked\n",
+               static_cast<unsigned long long>(stats.linesOffered), static_cast<unsigned long long>(stats.linesIntact),
+               static_cast<unsigned long long>(stats.bytesWritten), static_cast<unsigned long long>(stats.bytesDropped),
+               static_cast<unsigned long long>(stats.acksReceived), static_cast<unsigned long long>(stats.alarmsOffered));
+  closePseudoTerminal(pty);
+  return 0;
+}
+
+int runBench(const Options& options) {
+  PseudoTerminal pty;
+  if (!openPseudoTerminal(pty)) {
+    std::fprintf(stderr, "ecu_gateway: pty: %s\n", std::strerror(errno));
+    return 1;
+  }
+
+  double bytesPerSecond = bytesPerSecondForBaud(options.baud) * options.rate;
+  LoadGenerator generator(pty.masterFd, bytesPerSecond);
+  Gateway gateway(options.ringCapacity, OutputFormat::None, nullptr, false);
+  gateway.acknowledgeTo(pty.slaveFd);
+
+  std::atomic<bool> generatorDone{false};
+  auto start = std::chrono::steady_clock::now();
+  std::thread producer([&] {
+    generator.run(options.seconds, stopRequested);
+    generatorDone = true;
+  });
+
+  // Read until the generator has finished and the pty has drained
+  pollfd pfd{pty.slaveFd, POLLIN, 0};
+  while (true) {
+    int ready = poll(&pfd, 1, 100);
+    if (ready > 0) {
+      gateway.readFrom(pty.slaveFd);
+    } else if (generatorDone) {
+      break;
+    }
+  }
+  double elapsed = secondsSince(start);
+  producer.join();
+
+  const LoadStats& sent = generator.stats();
+  const GatewayCounters& received = gateway.counters();
+  std::printf("bench: target %s, %.2fs\n",
+              options.rate > 0 ? (std::to_string(options.rate) + "x link rate").c_str() : "unthrottled", elapsed);
+  std::printf("  sent     %llu lines, %llu bytes written, %llu bytes dropped at the link\n",
+              static_cast<unsigned long long>(sent.linesOffered), static_cast<unsigned long long>(sent.bytesWritten),
+              static_cast<unsigned long long>(sent.bytesDropped));
+  std::printf("  received %llu lines (%llu intact sent), %llu malformed, %zu oversized\n",
+              static_cast<unsigned long long>(received.lines), static_cast<unsigned long long>(sent.linesIntact),
+              static_cast<unsigned long long>(received.malformed), gateway.oversizedLines());
+  std::printf("  alarms   %llu sequenced, %llu acks sent, %llu acks dropped, %llu acks read back\n",
+              static_cast<unsigned long long>(sent.alarmsOffered), static_cast<unsigned long long>(received.acksSent),
+              static_cast<unsigned long long>(received.acksDropped), static_cast<unsigned long long>(sent.acksReceived));
+  std::printf("  parser   %.2f MB/s, %.0f lines/s, %.1f bytes/read\n", received.bytes / elapsed / 1e6,
+              received.lines / elapsed, received.reads ? static_cast<double>(received.bytes) / received.reads : 0.0);
+  gateway.printStats(stdout, elapsed, options.window);
+
+  closePseudoTerminal(pty);
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    printUsage();
+    return 2;
+  }
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  if (options.mode == "listen") {
+    return runListen(options);
+  }
+  if (options.mode == "loadgen") {
+    return runLoadgen(options);
+  }
+  return runBench(options);
+}
@@ -0,0 +1,87 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Sample {
+  int64_t timeNs;    // CLOCK_MONOTONIC time the line was received
+  uint16_t channel;
+  int32_t value;
+};
+
+// Fixed-capacity, time-ordered ring of samples. When full the oldest sample
+// is overwritten. Samples are appended in receive order, so the ring stays
+// sorted by time and range queries are a binary search.
+class SampleRing {
+ public:
+  explicit SampleRing(std::size_t capacity) : samples_(capacity) {}
+
+  void push(const Sample& sample) {
+    samples_[(head_ + size_) % samples_.size()] = sample;
+    if (size_ < samples_.size()) {
+      size_++;
+    } else {
+      head_ = (head_ + 1) % samples_.size();
+      overwritten_++;
+    }
+  }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return samples_.size(); }
+  uint64_t overwritten() const { return overwritten_; }
+
+  // Oldest sample is index 0
+  const Sample& at(std::size_t index) const { return samples_[(head_ + index) % samples_.size()]; }
+
+  // Calls onSample for every sample with fromNs <= timeNs < toNs
+  template <typename Callback>
+  void forEachInRange(int64_t fromNs, int64_t toNs, Callback&& onSample) const {
+    std::size_t low = 0;
+    std::size_t high = size_;
+    while (low < high) {
+      std::size_t mid = low + (high - low) / 2;
+      if (at(mid).timeNs < fromNs) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    for (std::size_t i = low; i < size_ && at(i).timeNs < toNs; i++) {
+      onSample(at(i));
+    }
+  }
+
+ private:
+  std::vector<Sample> samples_;
+  std::size_t head_ = 0;
+  std::size_t size_ = 0;
+  uint64_t overwritten_ = 0;
+};
+
+// Running aggregates for one channel
+struct ChannelStats {
+  uint64_t count = 0;
+  int32_t min = 0;
+  int32_t max = 0;
+  int32_t last = 0;
+  int64_t sum = 0;
+
+  void add(int32_t value) {
+    if (count == 0) {
+      min = max = value;
+    } else {
+      min = std::min(min, value);
+      max = std::max(max, value);
+    }
+    last = value;
+    sum += value;
+    count++;
+  }
+
+  double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+};
+
+#endif
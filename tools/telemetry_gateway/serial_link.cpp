@@ -0,0 +1,99 @@
+#include "serial_link.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+speed_t toSpeed(int baud) {
+  switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B0;
+  }
+}
+
+bool makeRaw(int fd, speed_t speed) {
+  termios tio{};
+  if (tcgetattr(fd, &tio) != 0) {
+    return false;
+  }
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cc[VMIN] = 1;
+  tio.c_cc[VTIME] = 0;
+  if (speed != B0) {
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+  }
+  return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+}  // namespace
+
+int openSerialPort(const std::string& path, int baud) {
+  speed_t speed = toSpeed(baud);
+  if (speed == B0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  int fd = open(path.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  if (!makeRaw(fd, speed)) {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return -1;
+  }
+  return fd;
+}
+
+bool openPseudoTerminal(PseudoTerminal& pty) {
+  pty.masterFd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (pty.masterFd < 0) {
+    return false;
+  }
+  if (grantpt(pty.masterFd) != 0 || unlockpt(pty.masterFd) != 0) {
+    closePseudoTerminal(pty);
+    return false;
+  }
+
+  const char* name = ptsname(pty.masterFd);
+  if (name == nullptr) {
+    closePseudoTerminal(pty);
+    return false;
+  }
+  pty.slavePath = name;
+
+  // Keep a slave descriptor open so the master does not see EIO while no
+  // reader is attached, and so the line discipline can be set to raw
+  pty.slaveFd = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (pty.slaveFd < 0 || !makeRaw(pty.slaveFd, B0)) {
+    closePseudoTerminal(pty);
+    return false;
+  }
+  return true;
+}
+
+void closePseudoTerminal(PseudoTerminal& pty) {
+  if (pty.slaveFd >= 0) {
+    close(pty.slaveFd);
+  }
+  if (pty.masterFd >= 0) {
+    close(pty.masterFd);
+  }
+  pty.slaveFd = -1;
+  pty.masterFd = -1;
+}
@@ -0,0 +1,26 @@
+#ifndef SERIAL_LINK_H
+#define SERIAL_LINK_H
+
+#include <string>
+
+// ECU link rate (Serial.begin in main.cpp)
+constexpr int ECU_BAUD_RATE = 115200;
+
+// Open a tty in raw 8N1 mode, read-write so alarms can be acknowledged.
+// Returns the file descriptor, or -1 with errno set.
+int openSerialPort(const std::string& path, int baud);
+
+struct PseudoTerminal {
+  int masterFd = -1;
+  int slaveFd = -1;
+  std::string slavePath;
+};
+
+// Create a raw-mode pty pair. Returns false with errno set on failure.
+bool openPseudoTerminal(PseudoTerminal& pty);
+void closePseudoTerminal(PseudoTerminal& pty);
+
+// Line-rate bytes per second for 8N1 framing
+inline double bytesPerSecondForBaud(int baud) { return baud / 10.0; }
+
+#endif
@@ -0,0 +1,111 @@
+#include "telemetry_protocol.h"
+
+#include <charconv>
+#include <cstdio>
+
+namespace {
+
+constexpr std::string_view CHANNEL_KEYS[CHANNEL_COUNT] = {
+  "OIL_WARN",
+  "COOLANT",
+  "FUEL",
+  "GLOW",
+  "BATT",
+  "RPM",
+  "ENGINE",
+  "LOOP_MS",
+  "TEMP_RATE",
+  "TEMP_ETA",
+};
+
+// Non-numeric messages the ECU sends
+constexpr std::string_view EVENT_KEYS[] = {
+  "DTC_SET",
+  "DTC_CLR",
+  "ALARM_SET",
+  "ALARM_CLR",
+  "RESET",
+  "WDT_STARVED",
+};
+
+bool isPrintable(std::string_view line) {
+  for (char c : line) {
+    if (static_cast<unsigned char>(c) < 0x20 || static_cast<unsigned char>(c) > 0x7E) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Message decodeLine(std::string_view line) {
+  Message message;
+  message.payload = line;
+
+  if (!isPrintable(line)) {
+    message.kind = MessageKind::Malformed;
+    return message;
+  }
+
+  std::size_t colon = line.find(':');
+  if (colon == std::string_view::npos) {
+    return message;  // Debug text such as "Setup complete. System ready."
+  }
+
+  std::string_view key = line.substr(0, colon);
+  std::string_view payload = line.substr(colon + 1);
+
+  // Sequence number suffix on alarm-class messages
+  int32_t sequence = -1;
+  std::size_t hash = payload.rfind('#');
+  if (hash != std::string_view::npos) {
+    std::string_view digits = payload.substr(hash + 1);
+    const char* end = digits.data() + digits.size();
+    auto result = std::from_chars(digits.data(), end, sequence);
+    if (digits.empty() || result.ec != std::errc() || result.ptr != end || sequence < 1 || sequence > 255) {
+      sequence = -1;
+    } else {
+      payload = payload.substr(0, hash);
+    }
+  }
+
+  for (uint16_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+    if (key != CHANNEL_KEYS[channel]) {
+      continue;
+    }
+
+    message.key = key;
+    message.payload = payload;
+    message.channel = channel;
+    message.sequence = sequence;
+
+    const char* end = payload.data() + payload.size();
+    auto result = std::from_chars(payload.data(), end, message.value);
+    message.kind = (payload.empty() || result.ec != std::errc() || result.ptr != end)
+                       ? MessageKind::Malformed
+                       : MessageKind::Sample;
+    return message;
+  }
+
+  for (std::string_view eventKey : EVENT_KEYS) {
+    if (key == eventKey) {
+      message.kind = payload.empty() ? MessageKind::Malformed : MessageKind::Event;
+      message.key = key;
+      message.payload = payload;
+      message.sequence = sequence;
+      return message;
+    }
+  }
+
+  return message;  // Debug text that happens to contain a colon
+}
+
+const char* channelName(uint16_t channel) {
+  return channel < CHANNEL_COUNT ? CHANNEL_KEYS[channel].data() : "UNKNOWN";
+}
+
+std::size_t formatAck(char* out, std::size_t capacity, int32_t sequence) {
+  int length = std::snprintf(out, capacity, "ACK:%d\n", sequence);
+  return length > 0 && static_cast<std::size_t>(length) < capacity ? static_cast<std::size_t>(length) : 0;
+}
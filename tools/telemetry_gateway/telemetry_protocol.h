@@ -0,0 +1,46 @@
+#ifndef TELEMETRY_PROTOCOL_H
+#define TELEMETRY_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Numeric channels sent by communication.cpp as "KEY:value" lines
+enum Channel : uint16_t {
+  CHANNEL_OIL_WARN,
+  CHANNEL_COOLANT,
+  CHANNEL_FUEL,
+  CHANNEL_GLOW,
+  CHANNEL_BATTERY,    // Tenths of a volt
+  CHANNEL_RPM,
+  CHANNEL_ENGINE,     // 1 = running
+  CHANNEL_LOOP_MS,    // Peak loop time, tenths of a millisecond
+  CHANNEL_TEMP_RATE,  // Coolant trend, tenths of a °C per minute
+  CHANNEL_TEMP_ETA,   // Seconds until coolant is critical (3600 = not rising)
+  CHANNEL_COUNT
+};
+
+enum class MessageKind {
+  Sample,     // Known numeric channel with a valid value
+  Event,      // Known non-numeric message (trouble codes, reset cause)
+  Text,       // Free-form debug output
+  Malformed   // Known key with a damaged value, or binary garbage
+};
+
+struct Message {
+  MessageKind kind = MessageKind::Text;
+  uint16_t channel = 0;
+  int32_t value = 0;
+  int32_t sequence = -1;    // Alarm-class messages end in "#<n>"; the ECU
+                            // repeats them until it receives "ACK:<n>"
+  std::string_view key;     // Views into the parser buffer, valid for the
+  std::string_view payload; // duration of the line callback only
+};
+
+Message decodeLine(std::string_view line);
+
+// Acknowledgement line for a sequenced message. Returns its length.
+std::size_t formatAck(char* out, std::size_t capacity, int32_t sequence);
+const char* channelName(uint16_t channel);
+
+#endif